@@ -0,0 +1,303 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "bitboard.h"
+
+// Attack and geometry tables generated at compile time, so movegen, attack
+// detection and eval look squares up instead of stepping file/rank deltas
+// with bounds checks.
+
+enum Direction : std::uint8_t
+{
+    DirectionNorth,
+    DirectionSouth,
+    DirectionEast,
+    DirectionWest,
+    DirectionNorthEast,
+    DirectionNorthWest,
+    DirectionSouthEast,
+    DirectionSouthWest,
+    DirectionCount
+};
+
+// Rook-like directions are [DirectionNorth, DirectionWest], bishop-like ones
+// [DirectionNorthEast, DirectionSouthWest].
+constexpr int FirstRookDirection = DirectionNorth;
+constexpr int FirstBishopDirection = DirectionNorthEast;
+
+// Squares walked from a square in one direction, nearest first.
+struct Ray
+{
+    std::uint8_t length{0};
+    std::array<std::uint8_t, 7> squares{};
+};
+
+namespace attack_tables_detail
+{
+    constexpr int DirectionDeltas[DirectionCount][2] = {
+        {0, 1}, {0, -1}, {1, 0}, {-1, 0},
+        {1, 1}, {-1, 1}, {1, -1}, {-1, -1}};
+
+    constexpr int KnightDeltas[8][2] = {
+        {1, 2},  {2, 1},  {2, -1}, {1, -2},
+        {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+
+    constexpr int KingDeltas[8][2] = {
+        {1, 0},  {1, 1},  {0, 1},  {-1, 1},
+        {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+
+    constexpr bool on_board(int file, int rank)
+    {
+        return file >= 0 && file < 8 && rank >= 0 && rank < 8;
+    }
+
+    constexpr int abs_diff(int a, int b)
+    {
+        return a > b ? a - b : b - a;
+    }
+
+    constexpr std::array<Bitboard, 64> step_attacks(const int (&deltas)[8][2])
+    {
+        std::array<Bitboard, 64> table{};
+        for (int square = 0; square < 64; ++square)
+        {
+            for (const auto& delta : deltas)
+            {
+                const int file = (square & 7) + delta[0];
+                const int rank = (square >> 3) + delta[1];
+                if (on_board(file, rank))
+                {
+                    table[square] |= square_bb(rank * 8 + file);
+                }
+            }
+        }
+        return table;
+    }
+
+    constexpr std::array<std::array<Bitboard, 64>, 2> pawn_attacks()
+    {
+        std::array<std::array<Bitboard, 64>, 2> table{};
+        for (int square = 0; square < 64; ++square)
+        {
+            for (int color = 0; color < 2; ++color)
+            {
+                const int rank = (square >> 3) + (color == 0 ? 1 : -1);
+                for (int df : {-1, 1})
+                {
+                    const int file = (square & 7) + df;
+                    if (on_board(file, rank))
+                    {
+                        table[color][square] |= square_bb(rank * 8 + file);
+                    }
+                }
+            }
+        }
+        return table;
+    }
+
+    constexpr std::array<std::array<Ray, 64>, DirectionCount> rays()
+    {
+        std::array<std::array<Ray, 64>, DirectionCount> table{};
+        for (int direction = 0; direction < DirectionCount; ++direction)
+        {
+            for (int square = 0; square < 64; ++square)
+            {
+                Ray& ray = table[direction][square];
+                int file = (square & 7) + DirectionDeltas[direction][0];
+                int rank = (square >> 3) + DirectionDeltas[direction][1];
+                while (on_board(file, rank))
+                {
+                    ray.squares[ray.length] = static_cast<std::uint8_t>(rank * 8 + file);
+                    ++ray.length;
+                    file += DirectionDeltas[direction][0];
+                    rank += DirectionDeltas[direction][1];
+                }
+            }
+        }
+        return table;
+    }
+
+    // Squares strictly between `from` and `to` when they share a line.
+    constexpr std::array<std::array<Bitboard, 64>, 64> between_masks()
+    {
+        std::array<std::array<Bitboard, 64>, 64> table{};
+        for (int from = 0; from < 64; ++from)
+        {
+            for (const auto& delta : DirectionDeltas)
+            {
+                Bitboard passed = 0;
+                int file = (from & 7) + delta[0];
+                int rank = (from >> 3) + delta[1];
+                while (on_board(file, rank))
+                {
+                    const int to = rank * 8 + file;
+                    table[from][to] = passed;
+                    passed |= square_bb(to);
+                    file += delta[0];
+                    rank += delta[1];
+                }
+            }
+        }
+        return table;
+    }
+
+    // Whole edge-to-edge line through `a` and `b` when they share one.
+    constexpr std::array<std::array<Bitboard, 64>, 64> line_masks()
+    {
+        std::array<std::array<Bitboard, 64>, 64> table{};
+        // Opposite directions: N/S, E/W, NE/SW, NW/SE.
+        constexpr int Lines[4][2] = {
+            {DirectionNorth, DirectionSouth},
+            {DirectionEast, DirectionWest},
+            {DirectionNorthEast, DirectionSouthWest},
+            {DirectionNorthWest, DirectionSouthEast}};
+
+        for (int from = 0; from < 64; ++from)
+        {
+            for (const auto& directions : Lines)
+            {
+                Bitboard line = square_bb(from);
+                for (const int direction : directions)
+                {
+                    const auto& delta = DirectionDeltas[direction];
+                    int file = (from & 7) + delta[0];
+                    int rank = (from >> 3) + delta[1];
+                    while (on_board(file, rank))
+                    {
+                        line |= square_bb(rank * 8 + file);
+                        file += delta[0];
+                        rank += delta[1];
+                    }
+                }
+
+                for (int to = 0; to < 64; ++to)
+                {
+                    if (to != from && (line & square_bb(to)) != 0)
+                    {
+                        table[from][to] = line;
+                    }
+                }
+            }
+        }
+        return table;
+    }
+
+    constexpr std::array<std::array<std::uint8_t, 64>, 64> square_distance()
+    {
+        std::array<std::array<std::uint8_t, 64>, 64> table{};
+        for (int a = 0; a < 64; ++a)
+        {
+            for (int b = 0; b < 64; ++b)
+            {
+                const int df = abs_diff(a & 7, b & 7);
+                const int dr = abs_diff(a >> 3, b >> 3);
+                table[a][b] = static_cast<std::uint8_t>(df > dr ? df : dr);
+            }
+        }
+        return table;
+    }
+
+    constexpr std::array<Bitboard, 8> file_masks()
+    {
+        std::array<Bitboard, 8> table{};
+        for (int file = 0; file < 8; ++file)
+        {
+            table[file] = Bitboard{0x0101010101010101ULL} << file;
+        }
+        return table;
+    }
+
+    constexpr std::array<Bitboard, 8> rank_masks()
+    {
+        std::array<Bitboard, 8> table{};
+        for (int rank = 0; rank < 8; ++rank)
+        {
+            table[rank] = Bitboard{0xFFULL} << (8 * rank);
+        }
+        return table;
+    }
+
+    // Squares on the same and adjacent files strictly ahead of a pawn; a pawn
+    // is passed when no enemy pawn stands on them.
+    constexpr std::array<std::array<Bitboard, 64>, 2> passed_pawn_masks()
+    {
+        std::array<std::array<Bitboard, 64>, 2> table{};
+        for (int square = 0; square < 64; ++square)
+        {
+            for (int color = 0; color < 2; ++color)
+            {
+                const int direction = (color == 0) ? 1 : -1;
+                for (int rank = (square >> 3) + direction; rank >= 0 && rank < 8; rank += direction)
+                {
+                    for (int df = -1; df <= 1; ++df)
+                    {
+                        const int file = (square & 7) + df;
+                        if (on_board(file, rank))
+                        {
+                            table[color][square] |= square_bb(rank * 8 + file);
+                        }
+                    }
+                }
+            }
+        }
+        return table;
+    }
+}
+
+inline constexpr std::array<Bitboard, 64> KnightAttacks =
+    attack_tables_detail::step_attacks(attack_tables_detail::KnightDeltas);
+inline constexpr std::array<Bitboard, 64> KingAttacks =
+    attack_tables_detail::step_attacks(attack_tables_detail::KingDeltas);
+// Indexed by static_cast<int>(Color): squares a pawn of that color attacks.
+inline constexpr std::array<std::array<Bitboard, 64>, 2> PawnAttacks =
+    attack_tables_detail::pawn_attacks();
+inline constexpr std::array<std::array<Ray, 64>, DirectionCount> SquareRays =
+    attack_tables_detail::rays();
+inline constexpr std::array<std::array<Bitboard, 64>, 64> BetweenMasks =
+    attack_tables_detail::between_masks();
+inline constexpr std::array<std::array<Bitboard, 64>, 64> LineMasks =
+    attack_tables_detail::line_masks();
+inline constexpr std::array<std::array<std::uint8_t, 64>, 64> SquareDistance =
+    attack_tables_detail::square_distance();
+inline constexpr std::array<Bitboard, 8> FileMasks = attack_tables_detail::file_masks();
+inline constexpr std::array<Bitboard, 8> RankMasks = attack_tables_detail::rank_masks();
+inline constexpr std::array<std::array<Bitboard, 64>, 2> PassedPawnMasks =
+    attack_tables_detail::passed_pawn_masks();
+
+static_assert(KnightAttacks[0] == (square_bb(10) | square_bb(17)), "knight table");
+static_assert(BetweenMasks[0][63] == 0x0040201008040200ULL, "between table");
+static_assert(SquareDistance[0][63] == 7, "distance table");
+
+// Squares a slider on `square` attacks along directions [firstDirection,
+// lastDirection), each ray stopping at and including the first square set
+// in `occupied`.
+inline Bitboard slider_attacks(int square, Bitboard occupied, int firstDirection, int lastDirection)
+{
+    Bitboard attacks = 0;
+    for (int direction = firstDirection; direction < lastDirection; ++direction)
+    {
+        const Ray& ray = SquareRays[static_cast<std::size_t>(direction)][static_cast<std::size_t>(square)];
+        for (std::uint8_t step = 0; step < ray.length; ++step)
+        {
+            const Bitboard bit = square_bb(ray.squares[step]);
+            attacks |= bit;
+            if ((occupied & bit) != 0)
+            {
+                break;
+            }
+        }
+    }
+    return attacks;
+}
+
+inline Bitboard bishop_attacks(int square, Bitboard occupied)
+{
+    return slider_attacks(square, occupied, FirstBishopDirection, DirectionCount);
+}
+
+inline Bitboard rook_attacks(int square, Bitboard occupied)
+{
+    return slider_attacks(square, occupied, FirstRookDirection, FirstBishopDirection);
+}
@@ -0,0 +1,149 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "board.h"
+#include "eval.h"
+#include "move.h"
+#include "perf_counters.h"
+#include "position.h"
+#include "search.h"
+
+namespace
+{
+    constexpr std::string_view BenchFens[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"};
+
+    constexpr std::size_t BenchFenCount = sizeof(BenchFens) / sizeof(BenchFens[0]);
+    constexpr int Iterations = 1000000;
+    constexpr int EvalIterations = 100000;
+    constexpr int PerftDepth = 3;
+    constexpr int SearchDepth = 6;
+
+    using Clock = std::chrono::steady_clock;
+
+    // Wall clock of one benchmark, plus hardware counters when they could
+    // be opened.
+    class Section
+    {
+    public:
+        Section(const char* label, PerfCounters& counters)
+            : label_(label), counters_(counters)
+        {
+            counters_.start();
+            start_ = Clock::now();
+        }
+
+        void finish(std::uint64_t units, const char* unit)
+        {
+            const auto end = Clock::now();
+            const PerfSample sample = counters_.stop();
+            const double seconds = std::chrono::duration<double>(end - start_).count();
+            const double count = static_cast<double>(units);
+            std::cout << label_ << ": " << static_cast<std::uint64_t>(count / seconds) << ' ' << unit << "s/s ("
+                      << seconds * 1e9 / count << " ns/" << unit << ")\n";
+            if (counters_.is_open())
+            {
+                std::cout << "    " << format_perf_sample(sample, units, unit) << '\n';
+            }
+        }
+
+    private:
+        const char* label_;
+        PerfCounters& counters_;
+        Clock::time_point start_;
+    };
+}
+
+int main()
+{
+    PerfCounters counters;
+    std::string error;
+    if (!counters.open(error))
+    {
+        std::cout << "hardware counters unavailable (" << error << "), wall clock only\n";
+    }
+
+    Position position;
+    char buffer[FenBufferSize];
+    std::uint64_t checksum = 0;
+
+    std::vector<Position> positions(BenchFenCount);
+    for (std::size_t i = 0; i < BenchFenCount; ++i)
+    {
+        positions[i].load_fen(BenchFens[i]);
+    }
+
+    Section parse("FEN parse", counters);
+    for (int i = 0; i < Iterations; ++i)
+    {
+        for (std::string_view fen : BenchFens)
+        {
+            position.load_fen(fen);
+            checksum ^= position.zobrist_key();
+        }
+    }
+    parse.finish(static_cast<std::uint64_t>(Iterations) * BenchFenCount, "fen");
+
+    Section write("FEN write", counters);
+    for (int i = 0; i < Iterations; ++i)
+    {
+        for (const Position& source : positions)
+        {
+            checksum += source.write_fen(buffer, sizeof(buffer));
+            checksum += static_cast<unsigned char>(buffer[0]);
+        }
+    }
+    write.finish(static_cast<std::uint64_t>(Iterations) * BenchFenCount, "fen");
+
+    std::vector<Board> boards(BenchFenCount);
+    for (std::size_t i = 0; i < BenchFenCount; ++i)
+    {
+        boards[i].load_fen(BenchFens[i]);
+    }
+
+    Section eval("Evaluate", counters);
+    for (int i = 0; i < EvalIterations; ++i)
+    {
+        for (const Board& board : boards)
+        {
+            checksum += static_cast<std::uint64_t>(evaluate(board));
+        }
+    }
+    eval.finish(static_cast<std::uint64_t>(EvalIterations) * BenchFenCount, "eval");
+
+    std::uint64_t perftNodes = 0;
+    Section perftSection("Perft", counters);
+    for (Board& board : boards)
+    {
+        perftNodes += perft(board, PerftDepth);
+    }
+    perftSection.finish(perftNodes, "node");
+    checksum += perftNodes;
+
+    Engine engine;
+    engine.set_info_callback({});
+    SearchLimits limits;
+    limits.maxDepth = SearchDepth;
+    std::uint64_t searchNodes = 0;
+    Section search("Search", counters);
+    for (Board& board : boards)
+    {
+        engine.clear();
+        searchNodes += static_cast<std::uint64_t>(engine.find_best_move(board, limits).nodes);
+    }
+    search.finish(searchNodes, "node");
+    checksum += searchNodes;
+
+    std::cout << "checksum " << checksum << '\n';
+    return 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// One bit per square, a1 = bit 0 ... h8 = bit 63.
+using Bitboard = std::uint64_t;
+
+constexpr Bitboard square_bb(int square) noexcept
+{
+    return Bitboard{1} << square;
+}
+
+inline int lsb(Bitboard bits) noexcept
+{
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward64(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+inline int pop_lsb(Bitboard& bits) noexcept
+{
+    const int square = lsb(bits);
+    bits &= bits - 1;
+    return square;
+}
+
+inline int popcount(Bitboard bits) noexcept
+{
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt64(bits));
+#else
+    return __builtin_popcountll(bits);
+#endif
+}
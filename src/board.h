@@ -1,57 +1,34 @@
 #pragma once
 
-#include <array>
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "move.h"
+#include "position.h"
 
-enum class Color : std::uint8_t
+// Undo stack and repetition keys for a game in progress. Each undo entry is
+// the full Position before the move, so undoing is a single copy back.
+class GameHistory
 {
-    White,
-    Black
-};
-
-enum class Piece : std::uint8_t
-{
-    None = 0,
-    WhitePawn,
-    WhiteKnight,
-    WhiteBishop,
-    WhiteRook,
-    WhiteQueen,
-    WhiteKing,
-    BlackPawn,
-    BlackKnight,
-    BlackBishop,
-    BlackRook,
-    BlackQueen,
-    BlackKing
-};
+public:
+    void push(const Position& positionBeforeMove);
+    [[nodiscard]] Position pop();
+    void clear() noexcept;
 
-inline bool is_white_piece(Piece piece) noexcept
-{
-    return piece >= Piece::WhitePawn && piece <= Piece::WhiteKing;
-}
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] std::size_t size() const noexcept;
+    // The position before the index-th recorded move, oldest first.
+    [[nodiscard]] const Position& at(std::size_t index) const;
 
-inline bool is_black_piece(Piece piece) noexcept
-{
-    return piece >= Piece::BlackPawn && piece <= Piece::BlackKing;
-}
+    // True when `key` already occurred within the last `halfmoveClock`
+    // plies, i.e. since the last irreversible move.
+    [[nodiscard]] bool is_repetition(std::uint64_t key, int halfmoveClock) const;
 
-inline bool is_empty_piece(Piece piece) noexcept
-{
-    return piece == Piece::None;
-}
-
-struct BoardState
-{
-    Color sideToMove{Color::White};
-    std::uint8_t castlingRights{0};
-    int enPassantSquare{-1};
-    int halfmoveClock{0};
-    int fullmoveNumber{1};
+private:
+    std::vector<Position> positions_{};
+    std::vector<std::uint64_t> keys_{};
 };
 
 class Board
@@ -59,11 +36,20 @@ class Board
 public:
     Board();
 
-    void load_fen(const std::string& fen);
+    bool load_fen(std::string_view fen, FenError* error = nullptr);
     [[nodiscard]] std::string to_fen() const;
+    // Sets up `current` as reached through the `count` positions at
+    // `earlier`, oldest first; they count for is_repetition() and can be
+    // undone back to.
+    void load_line(const Position* earlier, std::size_t count, const Position& current);
 
     [[nodiscard]] std::vector<Move> generate_legal_moves() const;
 
+    // Constant-time checks for moves from the hash table or killer slots;
+    // see the Position functions of the same names.
+    bool unpack_move(std::uint16_t packed, Move& out) const;
+    [[nodiscard]] bool is_legal(const Move& move) const;
+
     void make_move(const Move& move);
     void undo_move();
     void make_null_move();
@@ -75,25 +61,27 @@ public:
     void set_piece_at(int square, Piece piece);
 
     [[nodiscard]] std::uint64_t zobrist_key() const noexcept;
+    [[nodiscard]] std::uint64_t material_key() const noexcept;
+
+    // Constant time; see the Position functions of the same names.
+    [[nodiscard]] Bitboard pieces(Piece piece) const noexcept;
+    [[nodiscard]] int piece_count(Piece piece) const noexcept;
+    [[nodiscard]] int king_square(Color side) const noexcept;
 
     [[nodiscard]] bool is_in_check(Color side) const;
+    // True when the current position already occurred since the last
+    // irreversible move, counting the game moves made before the search.
+    [[nodiscard]] bool is_repetition() const;
+
+    [[nodiscard]] const Position& position() const noexcept;
+    [[nodiscard]] const GameHistory& history() const noexcept;
 
 private:
-    struct Undo
-    {
-        BoardState state{};
-        std::uint64_t zobristKey{0};
-        Piece capturedPiece{Piece::None};
-        Move move;
-    };
-
-    std::array<Piece, 64> squares_{};
-    BoardState state_{};
-    std::uint64_t zobristKey_{0};
-    std::vector<Undo> history_{};
-
-    [[nodiscard]] std::uint64_t compute_zobrist() const;
-    [[nodiscard]] std::vector<Move> generate_pseudo_legal_moves() const;
-    [[nodiscard]] bool is_square_attacked(int square, Color bySide) const;
-    [[nodiscard]] int find_king_square(Color side) const;
+    Position position_{};
+    GameHistory history_{};
 };
+
+// Number of leaf nodes of the legal move tree `depth` plies below `board`;
+// the move generator check, and the perft benchmark. Leaves `board` as it
+// found it.
+std::uint64_t perft(Board& board, int depth);
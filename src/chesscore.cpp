@@ -0,0 +1,356 @@
+#include "chesscore.h"
+
+#include <atomic>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "board.h"
+#include "eval.h"
+#include "move.h"
+#include "search.h"
+
+struct chesscore_engine
+{
+    explicit chesscore_engine(std::size_t ttEntries)
+        : engine(ttEntries)
+    {
+        engine.set_info_callback({});
+    }
+
+    Engine engine;
+    Board board;
+    std::atomic<bool> stopRequested{false};
+    chesscore_info_callback infoCallback{nullptr};
+    void* infoUserData{nullptr};
+};
+
+namespace
+{
+    constexpr const char* StartPositionFen =
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    bool find_legal_move(const Board& board, chesscore_move packed, Move& outMove)
+    {
+        for (const Move& move : board.generate_legal_moves())
+        {
+            if (pack_move(move) == packed)
+            {
+                outMove = move;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    SearchLimits to_search_limits(const chesscore_limits* limits, const std::atomic<bool>& stop)
+    {
+        SearchLimits searchLimits;
+        if (limits != nullptr)
+        {
+            if (limits->max_depth > 0)
+            {
+                searchLimits.maxDepth = limits->max_depth;
+            }
+            if (limits->movetime_ms > 0)
+            {
+                searchLimits.timeLimitMs = limits->movetime_ms;
+                searchLimits.useAbsoluteTime = true;
+                if (limits->max_depth <= 0)
+                {
+                    searchLimits.maxDepth = 64;
+                }
+            }
+        }
+        searchLimits.stop = &stop;
+        return searchLimits;
+    }
+
+    chesscore_result to_result(const SearchResult& searchResult)
+    {
+        chesscore_result result{};
+        result.status = CHESSCORE_OK;
+        result.depth = searchResult.depth;
+        result.score = searchResult.score;
+        result.best_move = pack_move(searchResult.bestMove);
+        result.nodes = searchResult.nodes;
+        result.mate = mate_in_moves(searchResult.score);
+        return result;
+    }
+
+    chesscore_result error_result(int status)
+    {
+        chesscore_result result{};
+        result.status = status;
+        return result;
+    }
+
+    // The caller resets stopRequested once per public call, so a stop also
+    // ends the rest of a batch.
+    chesscore_result run_search(chesscore_engine& handle, const chesscore_limits* limits)
+    {
+        return to_result(handle.engine.find_best_move(
+            handle.board, to_search_limits(limits, handle.stopRequested)));
+    }
+
+    // Runs `body`, turning any exception into `failure` so that none
+    // unwinds into a C caller.
+    template <typename Result, typename Body>
+    Result guarded(Result failure, Body&& body) noexcept
+    {
+        try
+        {
+            return body();
+        }
+        catch (...)
+        {
+            return failure;
+        }
+    }
+}
+
+extern "C"
+{
+
+uint32_t chesscore_abi_version(void)
+{
+    return CHESSCORE_ABI_VERSION;
+}
+
+chesscore_engine* chesscore_engine_create(size_t tt_entries)
+{
+    const std::size_t entries = (tt_entries == 0) ? Engine::DefaultTTEntries : tt_entries;
+    return guarded<chesscore_engine*>(nullptr, [entries]() { return new chesscore_engine(entries); });
+}
+
+void chesscore_engine_destroy(chesscore_engine* engine)
+{
+    delete engine;
+}
+
+void chesscore_engine_clear(chesscore_engine* engine)
+{
+    if (engine != nullptr)
+    {
+        engine->engine.clear();
+    }
+}
+
+void chesscore_set_info_callback(chesscore_engine* engine,
+                                 chesscore_info_callback callback,
+                                 void* user_data)
+{
+    if (engine == nullptr)
+    {
+        return;
+    }
+
+    engine->infoCallback = callback;
+    engine->infoUserData = user_data;
+
+    if (callback == nullptr)
+    {
+        engine->engine.set_info_callback({});
+        return;
+    }
+
+    const bool installed = guarded(false,
+                                   [engine]()
+                                   {
+                                       engine->engine.set_info_callback(
+                                           [engine](const SearchInfo& info)
+                                           {
+                                               chesscore_info cinfo{};
+                                               cinfo.depth = info.depth;
+                                               cinfo.score = info.score;
+                                               cinfo.best_move = pack_move(info.bestMove);
+                                               cinfo.nodes = info.nodes;
+                                               cinfo.nps = info.nps;
+                                               cinfo.mate = mate_in_moves(info.score);
+                                               engine->infoCallback(&cinfo, engine->infoUserData);
+                                           });
+                                       return true;
+                                   });
+    if (!installed)
+    {
+        // Out of memory: leave no stale callback behind.
+        engine->infoCallback = nullptr;
+        engine->engine.set_info_callback({});
+    }
+}
+
+int chesscore_set_position(chesscore_engine* engine,
+                           const char* fen,
+                           const chesscore_move* moves,
+                           size_t count)
+{
+    if (engine == nullptr || (moves == nullptr && count > 0))
+    {
+        return CHESSCORE_ERROR_INVALID_ARGUMENT;
+    }
+
+    return guarded(static_cast<int>(CHESSCORE_ERROR_INTERNAL),
+                   [&]()
+                   {
+                       Board board;
+                       if (!board.load_fen(fen != nullptr ? std::string_view(fen)
+                                                          : std::string_view(StartPositionFen)))
+                       {
+                           return static_cast<int>(CHESSCORE_ERROR_INVALID_FEN);
+                       }
+
+                       for (size_t i = 0; i < count; ++i)
+                       {
+                           Move move;
+                           if (!find_legal_move(board, moves[i], move))
+                           {
+                               return static_cast<int>(CHESSCORE_ERROR_ILLEGAL_MOVE);
+                           }
+                           board.make_move(move);
+                       }
+
+                       engine->board = std::move(board);
+                       return static_cast<int>(CHESSCORE_OK);
+                   });
+}
+
+int chesscore_get_fen(const chesscore_engine* engine, char* buffer, size_t capacity)
+{
+    if (engine == nullptr || buffer == nullptr ||
+        engine->board.position().write_fen(buffer, capacity) == 0)
+    {
+        return CHESSCORE_ERROR_INVALID_ARGUMENT;
+    }
+    return CHESSCORE_OK;
+}
+
+size_t chesscore_legal_moves(const chesscore_engine* engine,
+                             chesscore_move* moves,
+                             size_t capacity)
+{
+    if (engine == nullptr)
+    {
+        return 0;
+    }
+
+    return guarded(size_t{0},
+                   [&]()
+                   {
+                       const std::vector<Move> legalMoves = engine->board.generate_legal_moves();
+                       for (size_t i = 0; i < legalMoves.size() && i < capacity && moves != nullptr; ++i)
+                       {
+                           moves[i] = pack_move(legalMoves[i]);
+                       }
+                       return legalMoves.size();
+                   });
+}
+
+int chesscore_evaluate(const chesscore_engine* engine, int32_t* score)
+{
+    if (engine == nullptr || score == nullptr)
+    {
+        return CHESSCORE_ERROR_INVALID_ARGUMENT;
+    }
+
+    return guarded(static_cast<int>(CHESSCORE_ERROR_INTERNAL),
+                   [&]()
+                   {
+                       *score = evaluate(engine->board);
+                       return static_cast<int>(CHESSCORE_OK);
+                   });
+}
+
+int chesscore_search(chesscore_engine* engine,
+                     const chesscore_limits* limits,
+                     chesscore_result* result)
+{
+    if (engine == nullptr || result == nullptr)
+    {
+        return CHESSCORE_ERROR_INVALID_ARGUMENT;
+    }
+
+    engine->stopRequested.store(false, std::memory_order_relaxed);
+    *result = guarded(error_result(CHESSCORE_ERROR_INTERNAL), [&]() { return run_search(*engine, limits); });
+    return result->status;
+}
+
+void chesscore_stop(chesscore_engine* engine)
+{
+    if (engine != nullptr)
+    {
+        engine->stopRequested.store(true, std::memory_order_relaxed);
+    }
+}
+
+size_t chesscore_search_batch(chesscore_engine* engine,
+                              const char* const* fens,
+                              size_t count,
+                              const chesscore_limits* limits,
+                              chesscore_result* results)
+{
+    if (engine == nullptr || fens == nullptr || results == nullptr)
+    {
+        return 0;
+    }
+
+    engine->stopRequested.store(false, std::memory_order_relaxed);
+    size_t searched = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (engine->stopRequested.load(std::memory_order_relaxed))
+        {
+            results[i] = error_result(CHESSCORE_ERROR_STOPPED);
+            continue;
+        }
+
+        results[i] = guarded(error_result(CHESSCORE_ERROR_INTERNAL),
+                             [&]()
+                             {
+                                 if (fens[i] == nullptr || !engine->board.load_fen(fens[i]))
+                                 {
+                                     return error_result(CHESSCORE_ERROR_INVALID_FEN);
+                                 }
+                                 return run_search(*engine, limits);
+                             });
+        if (results[i].status == CHESSCORE_OK)
+        {
+            ++searched;
+        }
+    }
+    return searched;
+}
+
+size_t chesscore_evaluate_batch(const char* const* fens, size_t count, int32_t* scores)
+{
+    if (fens == nullptr || scores == nullptr)
+    {
+        return 0;
+    }
+
+    size_t evaluated = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const bool ok = guarded(false,
+                                [&]()
+                                {
+                                    Board board;
+                                    if (fens[i] == nullptr || !board.load_fen(fens[i]))
+                                    {
+                                        return false;
+                                    }
+                                    scores[i] = evaluate(board);
+                                    return true;
+                                });
+        if (ok)
+        {
+            ++evaluated;
+        }
+        else
+        {
+            scores[i] = 0;
+        }
+    }
+    return evaluated;
+}
+
+}
@@ -0,0 +1,161 @@
+#ifndef CHESSCORE_H
+#define CHESSCORE_H
+
+/*
+ * C interface to the engine, built as libchesscore. Everything here is plain
+ * C so services in any language can load it without a C++ toolchain.
+ *
+ * Each chesscore_engine owns its own hash table and game, and runs one call
+ * at a time; separate engines may be used from separate threads. The one
+ * exception is chesscore_stop, which may be called from any thread while a
+ * search is running.
+ *
+ * No C++ exception ever leaves these functions: failures such as running
+ * out of memory come back as CHESSCORE_ERROR_INTERNAL, or as a count of 0
+ * or NULL where the function returns one.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  if defined(CHESSCORE_BUILD)
+#    define CHESSCORE_API __declspec(dllexport)
+#  else
+#    define CHESSCORE_API __declspec(dllimport)
+#  endif
+#else
+#  define CHESSCORE_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped whenever a declaration below changes incompatibly. */
+#define CHESSCORE_ABI_VERSION 2
+
+enum
+{
+    CHESSCORE_OK = 0,
+    CHESSCORE_ERROR_INVALID_ARGUMENT = -1,
+    CHESSCORE_ERROR_INVALID_FEN = -2,
+    CHESSCORE_ERROR_ILLEGAL_MOVE = -3,
+    CHESSCORE_ERROR_INTERNAL = -4,
+    /* Batch positions left unsearched after chesscore_stop. */
+    CHESSCORE_ERROR_STOPPED = -5
+};
+
+/*
+ * Packed move: bits 0-5 origin square, bits 6-11 target square (a1 = 0,
+ * h8 = 63), bits 12-14 promotion (0 none, 1 knight, 2 bishop, 3 rook,
+ * 4 queen). Castling is the king's two-square move. Zero means "no move".
+ */
+typedef uint32_t chesscore_move;
+
+#define CHESSCORE_MOVE_NONE ((chesscore_move)0)
+
+typedef struct chesscore_engine chesscore_engine;
+
+typedef struct chesscore_limits
+{
+    int32_t max_depth;   /* <= 0 picks the engine default */
+    int32_t movetime_ms; /* <= 0 means no time limit */
+} chesscore_limits;
+
+typedef struct chesscore_result
+{
+    int32_t status; /* CHESSCORE_OK or an error code */
+    int32_t depth;
+    /*
+     * Centipawns from the side to move, unless `mate` is set: mate scores
+     * are then +-(30000 - plies to mate) and only their order is meaningful.
+     */
+    int32_t score;
+    chesscore_move best_move;
+    int64_t nodes;
+    /* Moves to mate: > 0 the side to move mates, < 0 it gets mated, 0 none. */
+    int32_t mate;
+} chesscore_result;
+
+typedef struct chesscore_info
+{
+    int32_t depth;
+    int32_t score; /* as in chesscore_result */
+    chesscore_move best_move;
+    int64_t nodes;
+    int64_t nps;
+    int32_t mate; /* as in chesscore_result */
+} chesscore_info;
+
+/* Called on the searching thread once per completed iteration. */
+typedef void (*chesscore_info_callback)(const chesscore_info* info, void* user_data);
+
+CHESSCORE_API uint32_t chesscore_abi_version(void);
+
+/* tt_entries of 0 picks the engine default. Returns NULL on allocation failure. */
+CHESSCORE_API chesscore_engine* chesscore_engine_create(size_t tt_entries);
+CHESSCORE_API void chesscore_engine_destroy(chesscore_engine* engine);
+
+/* Clears the hash table and move-ordering history. */
+CHESSCORE_API void chesscore_engine_clear(chesscore_engine* engine);
+
+CHESSCORE_API void chesscore_set_info_callback(chesscore_engine* engine,
+                                               chesscore_info_callback callback,
+                                               void* user_data);
+
+/*
+ * Sets the position to `fen` (NULL for the start position) followed by
+ * `count` moves. On error the previous position is kept.
+ */
+CHESSCORE_API int chesscore_set_position(chesscore_engine* engine,
+                                         const char* fen,
+                                         const chesscore_move* moves,
+                                         size_t count);
+
+/* Writes the current position's FEN; `capacity` must be at least 128. */
+CHESSCORE_API int chesscore_get_fen(const chesscore_engine* engine, char* buffer, size_t capacity);
+
+/* Fills `moves` with up to `capacity` legal moves and returns how many exist. */
+CHESSCORE_API size_t chesscore_legal_moves(const chesscore_engine* engine,
+                                           chesscore_move* moves,
+                                           size_t capacity);
+
+CHESSCORE_API int chesscore_evaluate(const chesscore_engine* engine, int32_t* score);
+
+CHESSCORE_API int chesscore_search(chesscore_engine* engine,
+                                   const chesscore_limits* limits,
+                                   chesscore_result* result);
+
+/*
+ * Asks a running chesscore_search or chesscore_search_batch on `engine` to
+ * return as soon as possible. A batch keeps the result of the position being
+ * searched and marks the rest CHESSCORE_ERROR_STOPPED.
+ */
+CHESSCORE_API void chesscore_stop(chesscore_engine* engine);
+
+/*
+ * Searches each FEN in turn with the same limits, writing one result per
+ * input. Returns the number of positions searched successfully; failures
+ * carry their error in result.status. The engine's position is left at the
+ * last FEN that loaded.
+ */
+CHESSCORE_API size_t chesscore_search_batch(chesscore_engine* engine,
+                                            const char* const* fens,
+                                            size_t count,
+                                            const chesscore_limits* limits,
+                                            chesscore_result* results);
+
+/*
+ * Static evaluation of each FEN from its side to move. Invalid FENs get a
+ * score of 0. Returns the number evaluated successfully.
+ */
+CHESSCORE_API size_t chesscore_evaluate_batch(const char* const* fens,
+                                              size_t count,
+                                              int32_t* scores);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,349 @@
+#include "cluster.h"
+
+#include "transposition_table.h"
+
+#if defined(_WIN32)
+
+namespace cluster
+{
+    struct Cluster::Shared
+    {
+    };
+
+    std::unique_ptr<Cluster> Cluster::launch(const ClusterOptions&, std::string& error)
+    {
+        error = "cluster mode needs fork() and is not available on this platform";
+        return nullptr;
+    }
+
+    Cluster::~Cluster() = default;
+
+    SearchResult Cluster::search(Engine& engine, Board& board, const SearchLimits& limits)
+    {
+        return engine.find_best_move(board, limits);
+    }
+
+    std::int64_t Cluster::helper_nodes() const noexcept
+    {
+        return 0;
+    }
+
+    int Cluster::helper_count() const noexcept
+    {
+        return 0;
+    }
+
+    void Cluster::clear()
+    {
+    }
+}
+
+#else
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "move.h"
+#include "position.h"
+
+namespace
+{
+    constexpr int MaxHelpers = 64;
+    // Game positions handed to the helpers for repetition detection; the
+    // fifty-move rule keeps the relevant stretch shorter than this.
+    constexpr std::size_t MaxSharedHistory = 128;
+    constexpr int IdlePollMs = 1;
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free &&
+                      std::atomic<std::uint32_t>::is_always_lock_free &&
+                      std::atomic<bool>::is_always_lock_free,
+                  "atomics in memory shared between processes must be lock-free");
+
+    // Written by one helper. The plain fields are published by storing the
+    // search id into finishedSearch.
+    struct HelperReport
+    {
+        std::atomic<std::uint32_t> finishedSearch{0};
+        std::atomic<std::int64_t> nodes{0};
+        std::int32_t depth{0};
+        std::int32_t score{0};
+        std::uint16_t move{0};
+    };
+
+    // Reaps the helper if it has exited; false once it is gone.
+    bool helper_alive(pid_t pid)
+    {
+        int status = 0;
+        pid_t reaped = 0;
+        while ((reaped = ::waitpid(pid, &status, WNOHANG)) < 0 && errno == EINTR)
+        {
+        }
+        return reaped == 0;
+    }
+
+    bool find_packed_move(Board& board, std::uint16_t packed, Move& out)
+    {
+        for (const Move& move : board.generate_legal_moves())
+        {
+            if (pack_move(move) == packed)
+            {
+                out = move;
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+namespace cluster
+{
+    // Start of the shared mapping; the exchange slots follow it. The
+    // coordinator writes the job fields before bumping searchId, and bumps
+    // clearId before the searchId of the next search. The job is the
+    // position plus the game positions since the last irreversible move,
+    // so helpers score repetitions as the caller's engine does.
+    struct Cluster::Shared
+    {
+        std::atomic<std::uint32_t> searchId{0};
+        std::atomic<std::uint32_t> clearId{0};
+        std::atomic<bool> stop{false};
+        std::atomic<bool> shutdown{false};
+        Position position{};
+        Position history[MaxSharedHistory]{};
+        std::uint32_t historyLength{0};
+        std::int32_t maxDepth{0};
+        HelperReport reports[MaxHelpers];
+    };
+
+    namespace
+    {
+        [[noreturn]] void run_helper(Cluster::Shared& shared,
+                                     HelperReport& report,
+                                     int helperIndex,
+                                     TTExchange exchange,
+                                     std::size_t ttEntries)
+        {
+            const pid_t coordinator = ::getppid();
+
+            Engine engine(ttEntries);
+            engine.set_exchange(&exchange);
+            engine.set_info_callback(
+                [&report](const SearchInfo& info)
+                {
+                    report.nodes.store(info.nodes, std::memory_order_relaxed);
+                });
+
+            // Both counters start at zero in launch(); a search posted before
+            // this process got scheduled must still be picked up.
+            std::uint32_t seenSearch = 0;
+            std::uint32_t seenClear = 0;
+
+            // Leave when told to, or when the coordinator died without
+            // telling us.
+            while (!shared.shutdown.load(std::memory_order_acquire) && ::getppid() == coordinator)
+            {
+                const std::uint32_t searchId = shared.searchId.load(std::memory_order_acquire);
+                const std::uint32_t clearId = shared.clearId.load(std::memory_order_acquire);
+                if (clearId != seenClear)
+                {
+                    engine.clear();
+                    seenClear = clearId;
+                }
+                if (searchId == seenSearch)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(IdlePollMs));
+                    continue;
+                }
+                seenSearch = searchId;
+
+                Board board;
+                board.load_line(shared.history, shared.historyLength, shared.position);
+
+                SearchLimits limits;
+                limits.maxDepth = shared.maxDepth;
+                limits.stop = &shared.stop;
+                limits.helperIndex = helperIndex;
+                const SearchResult result = engine.find_best_move(board, limits);
+
+                report.nodes.store(result.nodes, std::memory_order_relaxed);
+                report.depth = result.depth;
+                report.score = result.score;
+                report.move = pack_move(result.bestMove);
+                report.finishedSearch.store(searchId, std::memory_order_release);
+            }
+
+            // Skip the parent's atexit handlers and stdio buffers.
+            ::_exit(0);
+        }
+    }
+
+    std::unique_ptr<Cluster> Cluster::launch(const ClusterOptions& options, std::string& error)
+    {
+        if (options.helpers < 1 || options.helpers > MaxHelpers)
+        {
+            error = "helper count must be between 1 and " + std::to_string(MaxHelpers);
+            return nullptr;
+        }
+
+        const std::size_t exchangeEntries = std::max<std::size_t>(options.exchangeEntries, 1);
+        const std::size_t mappingSize =
+            sizeof(Shared) + exchangeEntries * sizeof(TranspositionTable::Slot);
+        void* mapping = ::mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED)
+        {
+            error = std::string("cannot map shared memory: ") + std::strerror(errno);
+            return nullptr;
+        }
+
+        std::unique_ptr<Cluster> cluster(new Cluster());
+        cluster->shared_ = new (mapping) Shared();
+        cluster->mappingSize_ = mappingSize;
+        auto* slots = new (static_cast<unsigned char*>(mapping) + sizeof(Shared))
+            TranspositionTable::Slot[exchangeEntries];
+        cluster->exchange_ =
+            std::make_unique<TTExchange>(slots, exchangeEntries, options.minSharedDepth);
+
+        // Nothing buffered may be written twice by the children.
+        std::cout.flush();
+        std::cerr.flush();
+
+        for (int i = 0; i < options.helpers; ++i)
+        {
+            const pid_t pid = ::fork();
+            if (pid < 0)
+            {
+                error = std::string("cannot start helper process: ") + std::strerror(errno);
+                return nullptr;
+            }
+            if (pid == 0)
+            {
+                run_helper(*cluster->shared_,
+                           cluster->shared_->reports[i],
+                           i + 1,
+                           TTExchange(slots, exchangeEntries, options.minSharedDepth),
+                           options.helperTTEntries);
+            }
+            cluster->helpers_.push_back(Helper{pid, i});
+        }
+        return cluster;
+    }
+
+    Cluster::~Cluster()
+    {
+        if (shared_ == nullptr)
+        {
+            return;
+        }
+
+        shared_->stop.store(true, std::memory_order_relaxed);
+        shared_->shutdown.store(true, std::memory_order_release);
+        for (const Helper& helper : helpers_)
+        {
+            int status = 0;
+            while (::waitpid(helper.pid, &status, 0) < 0 && errno == EINTR)
+            {
+            }
+        }
+        ::munmap(shared_, mappingSize_);
+    }
+
+    SearchResult Cluster::search(Engine& engine, Board& board, const SearchLimits& limits)
+    {
+        // Only positions since the last irreversible move can repeat.
+        const GameHistory& history = board.history();
+        const std::size_t reversible =
+            static_cast<std::size_t>(std::max(board.position().halfmove_clock(), 0));
+        const std::size_t count = std::min({history.size(), reversible, MaxSharedHistory});
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            shared_->history[i] = history.at(history.size() - count + i);
+        }
+        shared_->historyLength = static_cast<std::uint32_t>(count);
+        shared_->position = board.position();
+        shared_->maxDepth = limits.maxDepth;
+        for (const Helper& helper : helpers_)
+        {
+            shared_->reports[helper.report].nodes.store(0, std::memory_order_relaxed);
+        }
+        shared_->stop.store(false, std::memory_order_relaxed);
+        const std::uint32_t searchId =
+            shared_->searchId.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+        engine.set_exchange(exchange_.get());
+        SearchResult result = engine.find_best_move(board, limits);
+        engine.set_exchange(nullptr);
+
+        shared_->stop.store(true, std::memory_order_relaxed);
+
+        for (auto helper = helpers_.begin(); helper != helpers_.end();)
+        {
+            HelperReport& report = shared_->reports[helper->report];
+            bool alive = true;
+            while (alive && report.finishedSearch.load(std::memory_order_acquire) != searchId)
+            {
+                alive = helper_alive(helper->pid);
+                if (alive)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(IdlePollMs));
+                }
+            }
+            // A killed helper never reports; carry on with the others.
+            if (!alive)
+            {
+                helper = helpers_.erase(helper);
+                continue;
+            }
+
+            result.nodes += report.nodes.load(std::memory_order_relaxed);
+
+            // Helpers score a single line, so they cannot overrule multipv.
+            Move move;
+            if (limits.multiPv <= 1 && report.depth > result.depth &&
+                find_packed_move(board, report.move, move))
+            {
+                result.bestMove = move;
+                result.score = report.score;
+                result.depth = report.depth;
+                result.lines = {RootMoveScore{move, report.score}};
+            }
+            ++helper;
+        }
+        return result;
+    }
+
+    std::int64_t Cluster::helper_nodes() const noexcept
+    {
+        std::int64_t nodes = 0;
+        for (const Helper& helper : helpers_)
+        {
+            nodes += shared_->reports[helper.report].nodes.load(std::memory_order_relaxed);
+        }
+        return nodes;
+    }
+
+    int Cluster::helper_count() const noexcept
+    {
+        return static_cast<int>(helpers_.size());
+    }
+
+    void Cluster::clear()
+    {
+        // Helpers are idle between searches, so nothing writes the slots now.
+        exchange_->clear();
+        shared_->clearId.fetch_add(1, std::memory_order_acq_rel);
+    }
+}
+
+#endif
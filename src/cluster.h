@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "search.h"
+
+class Board;
+class TTExchange;
+
+namespace cluster
+{
+    struct ClusterOptions
+    {
+        // Helper processes searching beside the caller's engine.
+        int helpers{1};
+        // Transposition table of each helper.
+        std::size_t helperTTEntries{Engine::DefaultTTEntries};
+        // Slots in the table the processes exchange entries through.
+        std::size_t exchangeEntries{std::size_t{1} << 16};
+        // Shallower entries stay private to the process that found them.
+        std::uint8_t minSharedDepth{4};
+    };
+
+    // Lazy SMP across processes on one machine. launch() forks helper
+    // processes that share a memory mapping with the caller; for every
+    // search they analyse the same position as the caller's engine, all
+    // processes trade their deep transposition table entries through the
+    // mapping, and the caller collects the helpers' node counts and results.
+    class Cluster
+    {
+    public:
+        // Forks the helpers. Call it before starting any thread, since
+        // only the calling thread exists in the children. Returns nullptr
+        // and sets `error` on failure.
+        static std::unique_ptr<Cluster> launch(const ClusterOptions& options, std::string& error);
+
+        // Shuts the helpers down and waits for them.
+        ~Cluster();
+
+        Cluster(const Cluster&) = delete;
+        Cluster& operator=(const Cluster&) = delete;
+
+        // Runs engine.find_best_move() while the helpers search the same
+        // position, then stops them. Nodes are summed over all processes;
+        // the move comes from the process that completed the deepest
+        // iteration, the caller's engine winning ties. The helpers also get
+        // the game positions since the last irreversible move, so they
+        // score repetitions the same way. A helper that died is dropped and
+        // the search goes on without it.
+        SearchResult search(Engine& engine, Board& board, const SearchLimits& limits);
+
+        // Nodes the helpers have reported so far in the current search.
+        [[nodiscard]] std::int64_t helper_nodes() const noexcept;
+        [[nodiscard]] int helper_count() const noexcept;
+
+        // Empties the helpers' tables and the exchanged entries.
+        void clear();
+
+        // Layout of the shared mapping; defined in cluster.cpp.
+        struct Shared;
+
+    private:
+        Cluster() = default;
+
+        Shared* shared_{nullptr};
+        std::size_t mappingSize_{0};
+        std::unique_ptr<TTExchange> exchange_;
+        // Live helpers; `report` indexes Shared::reports.
+        struct Helper
+        {
+            int pid{0};
+            int report{0};
+        };
+        std::vector<Helper> helpers_;
+    };
+}
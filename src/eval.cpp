@@ -2,11 +2,13 @@
 
 #include <algorithm>
 #include <array>
-#include <cstdlib>
-#include <vector>
 
+#include "attack_tables.h"
 #include "board.h"
+#include "material.h"
 #include "move.h"
+#include "score.h"
+#include "trace.h"
 
 namespace
 {
@@ -15,16 +17,21 @@ namespace
     constexpr int BishopValue = 330;
     constexpr int RookValue = 500;
     constexpr int QueenValue = 900;
-    constexpr int MaxPhase = 24;
 
-    constexpr int PassedPawnBonusMg[8] = {0, 5, 10, 20, 35, 60, 100, 0};
-    constexpr int PassedPawnBonusEg[8] = {0, 10, 20, 40, 70, 110, 170, 0};
-    constexpr int IsolatedPenaltyMg = 15;
-    constexpr int IsolatedPenaltyEg = 10;
-    constexpr int DoubledPenaltyMg = 20;
-    constexpr int DoubledPenaltyEg = 12;
-    constexpr int BackwardPenaltyMg = 12;
-    constexpr int BackwardPenaltyEg = 8;
+    // A cheap score this far outside the window stands. The positional
+    // terms are clamped to PositionalLimit, so the full score is always
+    // within the margin of the cheap one.
+    constexpr int LazyMargin = 400;
+    constexpr int PositionalLimit = LazyMargin - 1;
+    // Wide enough that evaluate(board) never exits early.
+    constexpr int LazyWindowLimit = 1 << 24;
+
+    constexpr Score PassedPawnBonus[8] = {
+        Score(0, 0), Score(5, 10), Score(10, 20), Score(20, 40),
+        Score(35, 70), Score(60, 110), Score(100, 170), Score(0, 0)};
+    constexpr Score IsolatedPenalty(15, 10);
+    constexpr Score DoubledPenalty(20, 12);
+    constexpr Score BackwardPenalty(12, 8);
 
     constexpr int pawnTable[64] = {
          0,  0,  0,  0,  0,  0,  0,  0,
@@ -103,170 +110,184 @@ namespace
         -50, -30, -30, -30, -30, -30, -30, -50
     };
 
-    int mirror_square(int square)
+    constexpr int mirror_square(int square)
     {
-        const int file = file_of(square);
-        const int rank = rank_of(square);
-        const int mirroredRank = 7 - rank;
-        return make_square(file, mirroredRank);
+        return square ^ 56;
     }
 
-    int piece_phase_value(Piece piece)
+    // Value plus piece-square bonus for every piece on every square, each
+    // from its own side's point of view; indexed by Piece.
+    constexpr std::array<std::array<Score, 64>, 13> make_piece_square_scores()
     {
-        switch (piece)
+        std::array<std::array<Score, 64>, 13> table{};
+        for (int square = 0; square < 64; ++square)
         {
-        case Piece::WhiteKnight:
-        case Piece::BlackKnight: return 1;
-        case Piece::WhiteBishop:
-        case Piece::BlackBishop: return 1;
-        case Piece::WhiteRook:
-        case Piece::BlackRook: return 2;
-        case Piece::WhiteQueen:
-        case Piece::BlackQueen: return 4;
-        case Piece::WhitePawn:
-        case Piece::BlackPawn:
-        case Piece::WhiteKing:
-        case Piece::BlackKing:
-        case Piece::None:
-        default:
-            return 0;
+            for (int color = 0; color < 2; ++color)
+            {
+                const int idx = (color == 0) ? square : mirror_square(square);
+                const int offset = color * 6;
+                table[1 + offset][square] = Score(PawnValue + pawnTable[idx], PawnValue + pawnTable[idx]);
+                table[2 + offset][square] =
+                    Score(KnightValue + knightTable[idx], KnightValue + knightTable[idx]);
+                table[3 + offset][square] =
+                    Score(BishopValue + bishopTable[idx], BishopValue + bishopTable[idx]);
+                table[4 + offset][square] = Score(RookValue + rookTable[idx], RookValue + rookTable[idx]);
+                table[5 + offset][square] =
+                    Score(QueenValue + queenTable[idx], QueenValue + queenTable[idx]);
+                table[6 + offset][square] = Score(kingTableMidgame[idx], kingTableEndgame[idx]);
+            }
         }
+        return table;
     }
 
-    struct PhaseScore
+    constexpr std::array<std::array<Score, 64>, 13> PieceSquareScores = make_piece_square_scores();
+
+    template <Color Us>
+    int relative_rank(int square)
     {
-        int mg{0};
-        int eg{0};
+        return (Us == Color::White) ? rank_of(square) : 7 - rank_of(square);
+    }
+
+    // Slots of SideEval::attackedBy.
+    enum AttackType : std::size_t
+    {
+        ByPawn,
+        ByKnight,
+        ByBishop,
+        ByRook,
+        ByQueen,
+        ByKing,
+        AttackTypeCount
     };
 
+    // Per reachable square beyond the first few; indexed by AttackType.
+    constexpr Score MobilityWeight[AttackTypeCount] = {
+        Score(0, 0), Score(4, 4), Score(5, 5), Score(2, 4), Score(1, 2), Score(0, 0)};
+    constexpr int MobilityOffset[AttackTypeCount] = {0, 4, 6, 7, 13, 0};
+
+    // Units per square of the enemy king zone a piece attacks.
+    constexpr int KingAttackWeight[AttackTypeCount] = {0, 2, 2, 3, 5, 0};
+    constexpr int MaxKingAttackPenalty = 300;
+
+    constexpr Score ThreatByPawn(50, 40);
+    constexpr Score ThreatByMinor(30, 30);
+    constexpr Score HangingPiece(25, 15);
+
     struct SideEval
     {
-        PhaseScore base{};
+        Score base{};
         std::array<int, 8> pawnFileCounts{};
-        std::vector<int> pawnSquares;
-        std::vector<int> knightSquares;
-        std::vector<int> bishopSquares;
-        std::vector<int> rookSquares;
-        std::vector<int> queenSquares;
+        Bitboard pawns{0};
         int kingSquare{-1};
-    };
 
-    PhaseScore piece_square_score(Piece piece, int square, Color color)
-    {
-        const int idx = (color == Color::White) ? square : mirror_square(square);
-        PhaseScore score{};
+        // Squares attacked by each piece type, by anything, and by at least
+        // two pieces. Built once by the attack pass and shared by mobility,
+        // king safety and threats.
+        std::array<Bitboard, AttackTypeCount> attackedBy{};
+        Bitboard attacked{0};
+        Bitboard attackedTwice{0};
+
+        Score mobility{};
+        // Pieces attacking the enemy king zone, and their weighted squares.
+        int kingAttackers{0};
+        int kingAttackUnits{0};
 
-        switch (piece)
+        void add_attacks(AttackType type, Bitboard attacks)
         {
-        case Piece::WhitePawn:
-        case Piece::BlackPawn:
-            score.mg = PawnValue + pawnTable[idx];
-            score.eg = PawnValue + pawnTable[idx];
-            break;
-        case Piece::WhiteKnight:
-        case Piece::BlackKnight:
-            score.mg = KnightValue + knightTable[idx];
-            score.eg = KnightValue + knightTable[idx];
-            break;
-        case Piece::WhiteBishop:
-        case Piece::BlackBishop:
-            score.mg = BishopValue + bishopTable[idx];
-            score.eg = BishopValue + bishopTable[idx];
-            break;
-        case Piece::WhiteRook:
-        case Piece::BlackRook:
-            score.mg = RookValue + rookTable[idx];
-            score.eg = RookValue + rookTable[idx];
-            break;
-        case Piece::WhiteQueen:
-        case Piece::BlackQueen:
-            score.mg = QueenValue + queenTable[idx];
-            score.eg = QueenValue + queenTable[idx];
-            break;
-        case Piece::WhiteKing:
-        case Piece::BlackKing:
-            score.mg = kingTableMidgame[idx];
-            score.eg = kingTableEndgame[idx];
-            break;
-        case Piece::None:
-        default:
-            break;
+            attackedTwice |= attacked & attacks;
+            attacked |= attacks;
+            attackedBy[type] |= attacks;
         }
+    };
 
-        return score;
-    }
-
-    void accumulate_piece(Piece piece, int square, SideEval& side, int& phase)
+    void accumulate_piece(Piece piece, int square, SideEval& side)
     {
-        const Color color = is_white_piece(piece) ? Color::White : Color::Black;
-        const PhaseScore pst = piece_square_score(piece, square, color);
+        side.base += PieceSquareScores[static_cast<std::size_t>(piece)][static_cast<std::size_t>(square)];
 
-        side.base.mg += pst.mg;
-        side.base.eg += pst.eg;
-        phase += piece_phase_value(piece);
-
-        switch (piece)
-        {
-        case Piece::WhitePawn:
-        case Piece::BlackPawn:
+        if (piece == Piece::WhitePawn || piece == Piece::BlackPawn)
         {
-            const int file = file_of(square);
-            ++side.pawnFileCounts[static_cast<std::size_t>(file)];
-            side.pawnSquares.push_back(square);
-            break;
+            ++side.pawnFileCounts[static_cast<std::size_t>(file_of(square))];
+            side.pawns |= square_bb(square);
         }
-        case Piece::WhiteKnight:
-        case Piece::BlackKnight:
-            side.knightSquares.push_back(square);
-            break;
-        case Piece::WhiteBishop:
-        case Piece::BlackBishop:
-            side.bishopSquares.push_back(square);
-            break;
-        case Piece::WhiteRook:
-        case Piece::BlackRook:
-            side.rookSquares.push_back(square);
-            break;
-        case Piece::WhiteQueen:
-        case Piece::BlackQueen:
-            side.queenSquares.push_back(square);
-            break;
-        case Piece::WhiteKing:
-        case Piece::BlackKing:
+        else if (piece == Piece::WhiteKing || piece == Piece::BlackKing)
+        {
             side.kingSquare = square;
-            break;
-        case Piece::None:
-        default:
-            break;
         }
     }
 
-    bool is_passed_pawn(const Board& board, int square, Color side)
+    // Pawn and king attacks go first: the other pieces' mobility area
+    // excludes squares covered by enemy pawns.
+    template <Color Us>
+    void add_pawn_and_king_attacks(SideEval& us)
     {
-        const int file = file_of(square);
-        const int rank = rank_of(square);
-        const int direction = (side == Color::White) ? 1 : -1;
-        const Piece enemyPawn = (side == Color::White) ? Piece::BlackPawn : Piece::WhitePawn;
+        constexpr Bitboard NotFileA = ~FileMasks[0];
+        constexpr Bitboard NotFileH = ~FileMasks[7];
+        const Bitboard towardFileA = (Us == Color::White) ? (us.pawns & NotFileA) << 7 : (us.pawns & NotFileA) >> 9;
+        const Bitboard towardFileH = (Us == Color::White) ? (us.pawns & NotFileH) << 9 : (us.pawns & NotFileH) >> 7;
+        us.add_attacks(ByPawn, towardFileA);
+        us.add_attacks(ByPawn, towardFileH);
+
+        if (us.kingSquare != -1)
+        {
+            us.add_attacks(ByKing, KingAttacks[static_cast<std::size_t>(us.kingSquare)]);
+        }
+    }
 
-        for (int r = rank + direction; r >= 0 && r < 8; r += direction)
+    template <Color Us>
+    void add_piece_attacks(const Board& board, SideEval& us, const SideEval& them)
+    {
+        const Position& position = board.position();
+        const Bitboard occupied = position.pieces(Color::White) | position.pieces(Color::Black);
+        const Bitboard mobilityArea = ~position.pieces(Us) & ~them.attackedBy[ByPawn];
+        const Bitboard kingZone =
+            them.kingSquare == -1
+                ? 0
+                : KingAttacks[static_cast<std::size_t>(them.kingSquare)] | square_bb(them.kingSquare);
+
+        constexpr Piece pieceOf[AttackTypeCount] = {
+            Piece::WhitePawn, Piece::WhiteKnight, Piece::WhiteBishop,
+            Piece::WhiteRook, Piece::WhiteQueen, Piece::WhiteKing};
+        for (const AttackType type : {ByKnight, ByBishop, ByRook, ByQueen})
         {
-            for (int df = -1; df <= 1; ++df)
+            for (Bitboard squares = board.pieces(colored_piece(pieceOf[type], Us)); squares != 0;)
             {
-                const int f = file + df;
-                if (f < 0 || f > 7)
+                const int square = pop_lsb(squares);
+                Bitboard attacks = 0;
+                switch (type)
                 {
-                    continue;
+                case ByKnight:
+                    attacks = KnightAttacks[static_cast<std::size_t>(square)];
+                    break;
+                case ByBishop:
+                    attacks = bishop_attacks(square, occupied);
+                    break;
+                case ByRook:
+                    attacks = rook_attacks(square, occupied);
+                    break;
+                default:
+                    attacks = bishop_attacks(square, occupied) | rook_attacks(square, occupied);
+                    break;
                 }
+                us.add_attacks(type, attacks);
+
+                us.mobility += MobilityWeight[type] * (popcount(attacks & mobilityArea) - MobilityOffset[type]);
 
-                const int target = make_square(f, r);
-                if (board.piece_at(target) == enemyPawn)
+                const int zoneSquares = popcount(attacks & kingZone);
+                if (zoneSquares > 0)
                 {
-                    return false;
+                    ++us.kingAttackers;
+                    us.kingAttackUnits += KingAttackWeight[type] * zoneSquares;
                 }
             }
         }
+    }
 
-        return true;
+    template <Color Us>
+    bool is_passed_pawn(int square, const SideEval& opponent)
+    {
+        const Bitboard span =
+            PassedPawnMasks[static_cast<std::size_t>(Us)][static_cast<std::size_t>(square)];
+        return (span & opponent.pawns) == 0;
     }
 
     bool is_isolated_pawn(const SideEval& side, int file)
@@ -276,14 +297,14 @@ namespace
         return !left && !right;
     }
 
+    template <Color Us>
     bool is_backward_pawn(const Board& board,
                           int square,
-                          Color side,
                           const SideEval& opponent)
     {
         const int file = file_of(square);
         const int rank = rank_of(square);
-        const int direction = (side == Color::White) ? 1 : -1;
+        constexpr int direction = (Us == Color::White) ? 1 : -1;
         const int targetRank = rank + direction;
 
         if (targetRank < 0 || targetRank > 7)
@@ -309,15 +330,14 @@ namespace
             {
                 const int sq = make_square(adjFile, r);
                 const Piece p = board.piece_at(sq);
-                if ((side == Color::White && p == Piece::WhitePawn) ||
-                    (side == Color::Black && p == Piece::BlackPawn))
+                if (p == colored_piece(Piece::WhitePawn, Us))
                 {
                     return false;
                 }
             }
         }
 
-        const Piece enemyPawn = (side == Color::White) ? Piece::BlackPawn : Piece::WhitePawn;
+        constexpr Piece enemyPawn = colored_piece(Piece::WhitePawn, opposite_color(Us));
         for (int df : {-1, 1})
         {
             const int adjFile = file + df;
@@ -336,57 +356,54 @@ namespace
         return opponent.pawnFileCounts[static_cast<std::size_t>(file)] > 0;
     }
 
-    PhaseScore pawn_structure_score(const Board& board,
-                                    Color side,
-                                    const SideEval& us,
-                                    const SideEval& them)
+    template <Color Us>
+    Score pawn_structure_score(const Board& board,
+                               const SideEval& us,
+                               const SideEval& them)
     {
-        PhaseScore score{};
+        Score score{};
 
         for (int file = 0; file < 8; ++file)
         {
             const int count = us.pawnFileCounts[static_cast<std::size_t>(file)];
             if (count > 1)
             {
-                score.mg -= (count - 1) * DoubledPenaltyMg;
-                score.eg -= (count - 1) * DoubledPenaltyEg;
+                score -= DoubledPenalty * (count - 1);
             }
         }
 
-        for (int square : us.pawnSquares)
+        for (Bitboard pawns = us.pawns; pawns != 0;)
         {
+            const int square = pop_lsb(pawns);
             const int file = file_of(square);
-            const int relRank = (side == Color::White) ? rank_of(square) : 7 - rank_of(square);
+            const int relRank = relative_rank<Us>(square);
 
-            if (relRank >= 0 && relRank < 8 && is_passed_pawn(board, square, side))
+            if (relRank >= 0 && relRank < 8 && is_passed_pawn<Us>(square, them))
             {
-                score.mg += PassedPawnBonusMg[relRank];
-                score.eg += PassedPawnBonusEg[relRank];
+                score += PassedPawnBonus[relRank];
             }
 
             const bool isolated = is_isolated_pawn(us, file);
             if (isolated)
             {
-                score.mg -= IsolatedPenaltyMg;
-                score.eg -= IsolatedPenaltyEg;
+                score -= IsolatedPenalty;
             }
-            else if (is_backward_pawn(board, square, side, them))
+            else if (is_backward_pawn<Us>(board, square, them))
             {
-                score.mg -= BackwardPenaltyMg;
-                score.eg -= BackwardPenaltyEg;
+                score -= BackwardPenalty;
             }
         }
 
         return score;
     }
 
-    PhaseScore king_safety_score(const Board& board,
-                                 Color side,
-                                 const SideEval& us,
-                                 const SideEval& them,
-                                 int fullmoveNumber)
+    template <Color Us>
+    Score king_safety_score(const Board& board,
+                            const SideEval& us,
+                            const SideEval& them,
+                            int fullmoveNumber)
     {
-        PhaseScore score{};
+        Score score{};
         if (us.kingSquare == -1)
         {
             return score;
@@ -394,7 +411,7 @@ namespace
 
         const int kingFile = file_of(us.kingSquare);
         const int kingRank = rank_of(us.kingSquare);
-        const int direction = (side == Color::White) ? 1 : -1;
+        constexpr int direction = (Us == Color::White) ? 1 : -1;
 
         int pawnShield = 0;
         for (int df = -1; df <= 1; ++df)
@@ -414,8 +431,7 @@ namespace
                 }
 
                 const Piece p = board.piece_at(make_square(file, rank));
-                if ((side == Color::White && p == Piece::WhitePawn) ||
-                    (side == Color::Black && p == Piece::BlackPawn))
+                if (p == colored_piece(Piece::WhitePawn, Us))
                 {
                     ++pawnShield;
                     break;
@@ -424,7 +440,7 @@ namespace
         }
 
         const int missingShield = std::max(0, 3 - pawnShield);
-        score.mg -= missingShield * 12;
+        score -= Score(missingShield * 12, 0);
 
         for (int df = -1; df <= 1; ++df)
         {
@@ -439,164 +455,230 @@ namespace
 
             if (!friendlyPawns && !enemyPawns)
             {
-                score.mg -= 20;
+                score -= Score(20, 0);
             }
             else if (!friendlyPawns)
             {
-                score.mg -= 12;
+                score -= Score(12, 0);
             }
         }
 
+        constexpr int homeRank = (Us == Color::White) ? 0 : 7;
         const bool kingCastled =
-            (side == Color::White &&
-             (us.kingSquare == make_square(6, 0) || us.kingSquare == make_square(2, 0))) ||
-            (side == Color::Black &&
-             (us.kingSquare == make_square(6, 7) || us.kingSquare == make_square(2, 7)));
+            us.kingSquare == make_square(6, homeRank) || us.kingSquare == make_square(2, homeRank);
 
         if (kingCastled)
         {
-            score.mg += 16;
+            score += Score(16, 0);
         }
         else if (fullmoveNumber > 10)
         {
-            if ((side == Color::White && kingRank == 0) ||
-                (side == Color::Black && kingRank == 7))
+            if (kingRank == homeRank)
             {
-                score.mg -= 18;
+                score -= Score(18, 0);
             }
         }
 
-        const auto add_threat_penalty =
-            [&](const std::vector<int>& squares, int penalty)
-            {
-                for (int sq : squares)
-                {
-                    const int df = std::abs(file_of(sq) - kingFile);
-                    const int dr = std::abs(rank_of(sq) - kingRank);
-                    if (std::max(df, dr) <= 2)
-                    {
-                        score.mg -= penalty;
-                    }
-                }
-            };
-
-        add_threat_penalty(them.knightSquares, 6);
-        add_threat_penalty(them.bishopSquares, 5);
-        add_threat_penalty(them.rookSquares, 7);
-        add_threat_penalty(them.queenSquares, 9);
+        // A lone attacker rarely gets through; two or more that also hit
+        // squares of the zone twice, where our pawns do not help, do.
+        if (them.kingAttackers >= 2)
+        {
+            const Bitboard kingZone =
+                KingAttacks[static_cast<std::size_t>(us.kingSquare)] | square_bb(us.kingSquare);
+            const int units =
+                them.kingAttackUnits + popcount(them.attackedTwice & kingZone & ~us.attackedBy[ByPawn]);
+            score -= Score(std::min(units * units / 4, MaxKingAttackPenalty), 0);
+        }
 
         return score;
     }
 
-    PhaseScore activity_score(Color side, const SideEval& us, const SideEval& them)
+    template <Color Us>
+    Score activity_score(const Board& board, const SideEval& us, const SideEval& them)
     {
-        PhaseScore score{};
+        Score score = us.mobility;
 
-        for (int square : us.knightSquares)
+        for (Bitboard knights = board.pieces(colored_piece(Piece::WhiteKnight, Us)); knights != 0;)
         {
+            const int square = pop_lsb(knights);
             const int file = file_of(square);
-            const int relRank = (side == Color::White) ? rank_of(square) : 7 - rank_of(square);
+            const int relRank = relative_rank<Us>(square);
 
             if (relRank > 1)
             {
-                score.mg += 6;
+                score += Score(6, 0);
             }
 
             if (file >= 2 && file <= 5 && relRank >= 2 && relRank <= 5)
             {
-                score.mg += 8;
-                score.eg += 4;
+                score += Score(8, 4);
             }
 
             if (file == 0 || file == 7)
             {
-                score.mg -= 8;
+                score -= Score(8, 0);
             }
         }
 
-        for (int square : us.bishopSquares)
+        for (Bitboard bishops = board.pieces(colored_piece(Piece::WhiteBishop, Us)); bishops != 0;)
         {
-            const int relRank = (side == Color::White) ? rank_of(square) : 7 - rank_of(square);
+            const int relRank = relative_rank<Us>(pop_lsb(bishops));
             if (relRank > 0)
             {
-                score.mg += 5;
+                score += Score(5, 0);
             }
         }
 
-        for (int square : us.rookSquares)
+        for (Bitboard rooks = board.pieces(colored_piece(Piece::WhiteRook, Us)); rooks != 0;)
         {
+            const int square = pop_lsb(rooks);
             const int file = file_of(square);
-            const int relRank = (side == Color::White) ? rank_of(square) : 7 - rank_of(square);
+            const int relRank = relative_rank<Us>(square);
             const bool friendlyPawns = us.pawnFileCounts[static_cast<std::size_t>(file)] > 0;
             const bool enemyPawns = them.pawnFileCounts[static_cast<std::size_t>(file)] > 0;
 
             if (!friendlyPawns && !enemyPawns)
             {
-                score.mg += 20;
-                score.eg += 12;
+                score += Score(20, 12);
             }
             else if (!friendlyPawns)
             {
-                score.mg += 12;
-                score.eg += 6;
+                score += Score(12, 6);
             }
 
             if (relRank == 6)
             {
-                score.mg += 8;
-                score.eg += 6;
+                score += Score(8, 6);
             }
         }
 
-        for (int square : us.queenSquares)
+        for (Bitboard queens = board.pieces(colored_piece(Piece::WhiteQueen, Us)); queens != 0;)
         {
-            const int relRank = (side == Color::White) ? rank_of(square) : 7 - rank_of(square);
+            const int relRank = relative_rank<Us>(pop_lsb(queens));
             if (relRank >= 5)
             {
-                score.mg += 4;
+                score += Score(4, 0);
             }
         }
 
         return score;
     }
+
+    // Enemy pieces our attacks are already winning material against.
+    template <Color Us>
+    Score threats_score(const Board& board, const SideEval& us, const SideEval& them)
+    {
+        constexpr Color Them = opposite_color(Us);
+        const Bitboard theirPieces =
+            board.position().pieces(Them) & ~board.pieces(colored_piece(Piece::WhiteKing, Them));
+        const Bitboard nonPawns = theirPieces & ~them.pawns;
+        const Bitboard majors =
+            board.pieces(colored_piece(Piece::WhiteRook, Them)) | board.pieces(colored_piece(Piece::WhiteQueen, Them));
+
+        Score score{};
+        score += ThreatByPawn * popcount(us.attackedBy[ByPawn] & nonPawns);
+        score += ThreatByMinor * popcount((us.attackedBy[ByKnight] | us.attackedBy[ByBishop]) & majors);
+
+        // Undefended, or attacked twice and defended once, and not by a pawn.
+        const Bitboard weak = us.attacked & ~them.attackedBy[ByPawn] &
+                              (~them.attacked | (us.attackedTwice & ~them.attackedTwice));
+        score += HangingPiece * popcount(theirPieces & weak);
+        return score;
+    }
+
+    // Scaling the endgame half and tapering by phase never widen the gap
+    // between two scores, so bounding each half bounds the blended result.
+    Score clamp_positional(Score score)
+    {
+        return Score(std::clamp(score.mg(), -PositionalLimit, PositionalLimit),
+                     std::clamp(score.eg(), -PositionalLimit, PositionalLimit));
+    }
+
+    // Scales the endgame half, tapers by phase and turns white's point of
+    // view into the side to move's.
+    int blend(const Board& board, const MaterialEntry& material, Score score)
+    {
+        const int mgScore = score.mg();
+        int egScore = score.eg();
+        int scale = material.scaleFactor[egScore > 0 ? 0 : 1];
+        if (material.scale != nullptr)
+        {
+            scale = std::min(scale, material.scale(board));
+        }
+        egScore = egScore * scale / NormalScale;
+
+        const int blended = (mgScore * material.phase + egScore * (MaxPhase - material.phase)) / MaxPhase;
+        return board.side_to_move() == Color::White ? blended : -blended;
+    }
 }
 
 int evaluate(const Board& board)
 {
+    return evaluate(board, -LazyWindowLimit, LazyWindowLimit);
+}
+
+int evaluate(const Board& board, int alpha, int beta, LazyEvalStats* stats)
+{
+    TRACE_ZONE_SAMPLED("evaluate", 1024);
+    thread_local MaterialTable materialTable;
+    const MaterialEntry& material = materialTable.probe(board.position());
+    if (material.evaluate != nullptr)
+    {
+        const int score = material.evaluate(board, material.strongSide);
+        return board.side_to_move() == material.strongSide ? score : -score;
+    }
+
     SideEval white{};
     SideEval black{};
-    int phase = 0;
 
-    for (int square = 0; square < 64; ++square)
+    for (int index = static_cast<int>(Piece::WhitePawn); index <= static_cast<int>(Piece::BlackKing); ++index)
     {
-        const Piece piece = board.piece_at(square);
-        if (piece == Piece::None)
+        const Piece piece = static_cast<Piece>(index);
+        SideEval& side = is_white_piece(piece) ? white : black;
+        for (Bitboard squares = board.pieces(piece); squares != 0;)
         {
-            continue;
+            accumulate_piece(piece, pop_lsb(squares), side);
         }
+    }
 
-        SideEval& side = is_white_piece(piece) ? white : black;
-        accumulate_piece(piece, square, side, phase);
+    if (stats != nullptr)
+    {
+        ++stats->calls;
     }
 
+    // Material and piece-square terms first; when they are far outside the
+    // window the remaining terms cannot bring the score back into it.
+    const int lazyScore = blend(board, material, white.base - black.base + material.imbalance);
+    if (lazyScore + LazyMargin <= alpha || lazyScore - LazyMargin >= beta)
+    {
+        if (stats != nullptr)
+        {
+            ++stats->lazyExits;
+        }
+        return lazyScore;
+    }
+
+    add_pawn_and_king_attacks<Color::White>(white);
+    add_pawn_and_king_attacks<Color::Black>(black);
+    add_piece_attacks<Color::White>(board, white, black);
+    add_piece_attacks<Color::Black>(board, black, white);
+
     const int fullmoveNumber = board.fullmove_number();
 
-    const PhaseScore whitePawn = pawn_structure_score(board, Color::White, white, black);
-    const PhaseScore blackPawn = pawn_structure_score(board, Color::Black, black, white);
+    const Score whitePawn = pawn_structure_score<Color::White>(board, white, black);
+    const Score blackPawn = pawn_structure_score<Color::Black>(board, black, white);
 
-    const PhaseScore whiteKing = king_safety_score(board, Color::White, white, black, fullmoveNumber);
-    const PhaseScore blackKing = king_safety_score(board, Color::Black, black, white, fullmoveNumber);
+    const Score whiteKing = king_safety_score<Color::White>(board, white, black, fullmoveNumber);
+    const Score blackKing = king_safety_score<Color::Black>(board, black, white, fullmoveNumber);
 
-    const PhaseScore whiteActivity = activity_score(Color::White, white, black);
-    const PhaseScore blackActivity = activity_score(Color::Black, black, white);
+    const Score whiteActivity = activity_score<Color::White>(board, white, black);
+    const Score blackActivity = activity_score<Color::Black>(board, black, white);
 
-    int mgScore = white.base.mg + whitePawn.mg + whiteKing.mg + whiteActivity.mg -
-                  (black.base.mg + blackPawn.mg + blackKing.mg + blackActivity.mg);
-    int egScore = white.base.eg + whitePawn.eg + whiteKing.eg + whiteActivity.eg -
-                  (black.base.eg + blackPawn.eg + blackKing.eg + blackActivity.eg);
+    const Score whiteThreats = threats_score<Color::White>(board, white, black);
+    const Score blackThreats = threats_score<Color::Black>(board, black, white);
 
-    const int phaseClamped = std::clamp(phase, 0, MaxPhase);
-    const int blended = (mgScore * phaseClamped + egScore * (MaxPhase - phaseClamped)) / MaxPhase;
+    const Score positional = clamp_positional(whitePawn + whiteKing + whiteActivity + whiteThreats -
+                                              (blackPawn + blackKing + blackActivity + blackThreats));
 
-    return board.side_to_move() == Color::White ? blended : -blended;
+    return blend(board, material, white.base - black.base + material.imbalance + positional);
 }
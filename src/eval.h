@@ -1,6 +1,22 @@
 #pragma once
 
+#include <cstdint>
+
 class Board;
 
+// How often the windowed evaluate() could skip the positional terms.
+struct LazyEvalStats
+{
+    std::int64_t calls{0};
+    std::int64_t lazyExits{0};
+};
+
 int evaluate(const Board& board);
 
+// Lazy evaluation for callers that only compare the score against
+// (alpha, beta): when material and piece-square terms alone are far
+// outside the window, returns them without computing pawn structure, king
+// safety, activity and threats. Those terms are bounded so that the full
+// score would have been outside the window as well; inside the window the
+// result equals evaluate().
+int evaluate(const Board& board, int alpha, int beta, LazyEvalStats* stats = nullptr);
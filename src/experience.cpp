@@ -0,0 +1,189 @@
+#include "experience.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include "transposition_table.h"
+#include "zobrist.h"
+
+namespace
+{
+    // Experience file: this header, then one ExperienceRecord per position,
+    // all native-endian.
+    struct ExperienceHeader
+    {
+        char magic[8];
+        std::uint32_t formatVersion;
+        std::uint32_t byteOrderMark;
+        std::uint64_t recordCount;
+        std::uint64_t zobristSeed;
+        std::uint64_t zobristFingerprint;
+    };
+
+    struct ExperienceRecord
+    {
+        std::uint64_t key;
+        std::uint16_t move;
+        std::int16_t score;
+        std::uint8_t depth;
+        std::uint8_t reserved[3];
+    };
+
+    constexpr char ExperienceMagic[8] = {'C', 'H', 'E', 'S', 'S', 'X', 'P', '\0'};
+    constexpr std::uint32_t ExperienceFormatVersion = 1;
+    constexpr std::uint32_t ByteOrderMark = 0x01020304;
+
+    bool write_file(const std::string& path,
+                    const std::vector<ExperienceRecord>& records)
+    {
+        ExperienceHeader header{};
+        std::memcpy(header.magic, ExperienceMagic, sizeof(ExperienceMagic));
+        header.formatVersion = ExperienceFormatVersion;
+        header.byteOrderMark = ByteOrderMark;
+        header.recordCount = records.size();
+        header.zobristSeed = ZobristSeed;
+        header.zobristFingerprint = ZobristFingerprint;
+
+        // Write beside the target and rename, so a crash mid-write leaves
+        // the previous file intact.
+        const std::string tempPath = path + ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(records.data()),
+                      static_cast<std::streamsize>(records.size() * sizeof(ExperienceRecord)));
+            out.close();
+            if (!out)
+            {
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tempPath, path, ec);
+        return !ec;
+    }
+}
+
+ExperienceStore::~ExperienceStore()
+{
+    if (writer_.joinable())
+    {
+        writer_.join();
+    }
+}
+
+bool ExperienceStore::open(const std::string& path, std::string& error)
+{
+    std::unordered_map<std::uint64_t, ExperienceEntry> loaded;
+
+    std::ifstream in(path, std::ios::binary);
+    if (in)
+    {
+        ExperienceHeader header{};
+        in.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!in || std::memcmp(header.magic, ExperienceMagic, sizeof(ExperienceMagic)) != 0)
+        {
+            error = path + " is not an experience file";
+            return false;
+        }
+        if (header.formatVersion != ExperienceFormatVersion ||
+            header.byteOrderMark != ByteOrderMark ||
+            header.zobristSeed != ZobristSeed ||
+            header.zobristFingerprint != ZobristFingerprint)
+        {
+            error = path + " was written by an incompatible engine build";
+            return false;
+        }
+
+        ExperienceRecord record{};
+        for (std::uint64_t i = 0; i < header.recordCount; ++i)
+        {
+            if (!in.read(reinterpret_cast<char*>(&record), sizeof(record)))
+            {
+                error = path + " is truncated";
+                return false;
+            }
+            loaded[record.key] = ExperienceEntry{record.move, record.score, record.depth};
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    path_ = path;
+    entries_ = std::move(loaded);
+    return true;
+}
+
+bool ExperienceStore::is_open() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !path_.empty();
+}
+
+std::size_t ExperienceStore::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void ExperienceStore::record(std::uint64_t key, const ExperienceEntry& entry)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (path_.empty() || entry.depth == 0)
+    {
+        return;
+    }
+
+    const auto [it, inserted] = entries_.try_emplace(key, entry);
+    if (!inserted && entry.depth >= it->second.depth)
+    {
+        it->second = entry;
+    }
+}
+
+void ExperienceStore::save_async()
+{
+    std::string path;
+    std::vector<ExperienceRecord> records;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (path_.empty())
+        {
+            return;
+        }
+        path = path_;
+        records.reserve(entries_.size());
+        for (const auto& [key, entry] : entries_)
+        {
+            records.push_back(ExperienceRecord{key, entry.move, entry.score, entry.depth, {}});
+        }
+    }
+
+    // One save in flight at a time; a newer snapshot supersedes it anyway.
+    if (writer_.joinable())
+    {
+        writer_.join();
+    }
+    writer_ = std::thread(
+        [path = std::move(path), records = std::move(records)]
+        {
+            write_file(path, records);
+        });
+}
+
+void ExperienceStore::preload(TranspositionTable& table) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [key, entry] : entries_)
+    {
+        TTData data;
+        data.move = entry.move;
+        data.score = entry.score;
+        data.depth = entry.depth;
+        data.bound = TTBound::Exact;
+        table.store(key, data);
+    }
+}
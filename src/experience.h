@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+class TranspositionTable;
+
+// What the engine concluded about one position it searched.
+struct ExperienceEntry
+{
+    std::uint16_t move{0};
+    std::int16_t score{0};
+    std::uint8_t depth{0};
+};
+
+// Deepest search result per position, kept on disk across sessions and
+// keyed by Zobrist key. Saving happens on a background thread so the
+// caller is not blocked on file I/O between games.
+class ExperienceStore
+{
+public:
+    ExperienceStore() = default;
+    ~ExperienceStore();
+
+    ExperienceStore(const ExperienceStore&) = delete;
+    ExperienceStore& operator=(const ExperienceStore&) = delete;
+
+    // Switches to `path` and reads it; a missing file starts empty. Returns
+    // false and sets `error` if the file exists but cannot be used.
+    bool open(const std::string& path, std::string& error);
+    [[nodiscard]] bool is_open() const;
+    [[nodiscard]] std::size_t size() const;
+
+    // Keeps the deeper of the new and the stored result.
+    void record(std::uint64_t key, const ExperienceEntry& entry);
+
+    // Writes a snapshot of all entries in the background, replacing the
+    // file atomically once complete.
+    void save_async();
+
+    // Seeds the table with every entry as an exact root score.
+    void preload(TranspositionTable& table) const;
+
+private:
+    mutable std::mutex mutex_;
+    std::string path_;
+    std::unordered_map<std::uint64_t, ExperienceEntry> entries_;
+    std::thread writer_;
+};
@@ -10,6 +10,8 @@
 #include <iostream>
 #include <sstream>
 
+#include "trace.h"
+
 namespace
 {
     std::string current_utc_timestamp()
@@ -85,6 +87,7 @@ std::filesystem::path history::history_dir()
 
 void history::save_game(GameRecord record)
 {
+    TRACE_ZONE("history save");
     if (record.utc.empty())
     {
         record.utc = current_utc_timestamp();
@@ -127,6 +130,7 @@ void history::save_game(GameRecord record)
 
 std::vector<GameMeta> history::list_games()
 {
+    TRACE_ZONE("history list");
     std::vector<GameMeta> games;
     const std::filesystem::path dir = history_dir();
 
@@ -178,6 +182,7 @@ std::vector<GameMeta> history::list_games()
 
 GameRecord history::load_game(const std::filesystem::path& path)
 {
+    TRACE_ZONE("history load");
     GameRecord record;
 
     std::ifstream in(path);
@@ -1,21 +1,107 @@
 #include "board.h"
+#include "cluster.h"
+#include "server.h"
+#include "trace.h"
 #include "uci.h"
 #include "ui.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
 #include <string>
 
+namespace
+{
+    // Writes the recorded trace zones when main() returns, whichever mode
+    // it ran.
+    struct TraceExport
+    {
+        std::string path;
+
+        ~TraceExport()
+        {
+            std::string error;
+            if (!path.empty() && !trace::write_chrome_json(path, error))
+            {
+                std::cerr << "cannot write trace: " << error << '\n';
+            }
+        }
+    };
+}
+
 int main(int argc, char* argv[])
 {
     Board board;
+    TraceExport traceExport;
 
     for (int i = 1; i < argc; ++i)
     {
-        if (std::string(argv[i]) == "--uci")
+        const std::string arg(argv[i]);
+        // --trace FILE, before the mode: Chrome trace JSON written on exit.
+        if (arg == "--trace" && i + 1 < argc)
+        {
+            ++i;
+            if (trace::enabled())
+            {
+                traceExport.path = argv[i];
+                trace::set_thread_name("main");
+            }
+            else
+            {
+                std::cerr << "--trace ignored: configure with -DCHESS_TRACE=ON to compile in trace zones\n";
+            }
+            continue;
+        }
+
+        if (arg == "--uci")
         {
             const uci::EngineInfo info{"SDL2 Chess Engine", "serialcoder"};
-            uci::run(board, info);
+
+            // --uci --cluster N: N helper processes search every position too.
+            std::unique_ptr<cluster::Cluster> helpers;
+            if (i + 2 < argc && std::string(argv[i + 1]) == "--cluster")
+            {
+                cluster::ClusterOptions options;
+                options.helpers = std::atoi(argv[i + 2]);
+                std::string error;
+                helpers = cluster::Cluster::launch(options, error);
+                if (!helpers)
+                {
+                    std::cerr << "cannot start cluster: " << error << '\n';
+                    return 1;
+                }
+            }
+
+            uci::run(board, info, helpers.get());
             return 0;
         }
+
+        if (arg == "--serve")
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "usage: " << argv[0]
+                          << " --serve <socket path> [--threads N] [--hash MB]\n";
+                return 1;
+            }
+
+            server::ServerOptions options;
+            options.socketPath = argv[++i];
+            for (++i; i + 1 < argc; i += 2)
+            {
+                const std::string option(argv[i]);
+                if (option == "--threads")
+                {
+                    options.threads = std::atoi(argv[i + 1]);
+                }
+                else if (option == "--hash")
+                {
+                    options.hashMb = static_cast<std::size_t>(std::max(1, std::atoi(argv[i + 1])));
+                }
+            }
+            return server::run(options);
+        }
     }
 
     ui::run(board);
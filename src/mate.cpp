@@ -0,0 +1,241 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "mate_search.h"
+#include "move.h"
+#include "thread_pool.h"
+
+namespace
+{
+    // One puzzle: the position and, from an EPD "dm N" opcode, the mate
+    // length the collection expects (0 if not given).
+    struct Puzzle
+    {
+        std::string fen;
+        int expectedMoves{0};
+    };
+
+    bool is_number(const std::string& token)
+    {
+        return !token.empty() && token.find_first_not_of("0123456789") == std::string::npos;
+    }
+
+    // Accepts a FEN, or an EPD line: four position fields followed by
+    // opcodes such as "dm 3;".
+    bool parse_puzzle(const std::string& line, Puzzle& puzzle)
+    {
+        std::istringstream stream(line);
+        std::vector<std::string> tokens;
+        std::string token;
+        while (stream >> token)
+        {
+            tokens.push_back(token);
+        }
+        if (tokens.size() < 4 || tokens.front().front() == '#')
+        {
+            return false;
+        }
+
+        std::size_t fenFields = 4;
+        while (fenFields < tokens.size() && fenFields < 6 && is_number(tokens[fenFields]))
+        {
+            ++fenFields;
+        }
+        puzzle.fen.clear();
+        for (std::size_t i = 0; i < fenFields; ++i)
+        {
+            puzzle.fen += (i == 0 ? "" : " ") + tokens[i];
+        }
+
+        puzzle.expectedMoves = 0;
+        for (std::size_t i = fenFields; i + 1 < tokens.size(); ++i)
+        {
+            if (tokens[i] == "dm")
+            {
+                puzzle.expectedMoves = std::atoi(tokens[i + 1].c_str());
+            }
+        }
+        return true;
+    }
+
+    // Result line of one puzzle, printed once all puzzles before it are.
+    struct Outcome
+    {
+        std::string text;
+        bool solved{false};
+        bool mismatched{false};
+        std::int64_t nodes{0};
+    };
+
+    Outcome solve_puzzle(MateSolver& solver, const Puzzle& puzzle, const MateLimits& defaults)
+    {
+        using Clock = std::chrono::steady_clock;
+        Outcome outcome;
+        std::ostringstream text;
+
+        Board board;
+        FenError error;
+        if (!board.load_fen(puzzle.fen, &error))
+        {
+            outcome.text = std::string("invalid fen: ") + error.message;
+            return outcome;
+        }
+
+        MateLimits limits = defaults;
+        if (puzzle.expectedMoves > 0)
+        {
+            limits.maxMoves = puzzle.expectedMoves;
+        }
+
+        const auto start = Clock::now();
+        const MateResult result = solver.solve(board, limits);
+        const auto ms =
+            std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+        outcome.nodes = result.nodes;
+
+        if (result.found)
+        {
+            outcome.solved = true;
+            text << "mate in " << result.mateIn << " pv";
+            for (const Move& move : result.pv)
+            {
+                text << ' ' << move.to_uci();
+            }
+            if (puzzle.expectedMoves > 0 && result.mateIn != puzzle.expectedMoves)
+            {
+                outcome.mismatched = true;
+                text << " (expected dm " << puzzle.expectedMoves << ')';
+            }
+        }
+        else
+        {
+            text << (result.aborted ? "no mate found within limits, up to "
+                                    : "no forced mate in ")
+                 << limits.maxMoves;
+        }
+        text << " nodes " << result.nodes << " time " << ms << "ms";
+        outcome.text = text.str();
+        return outcome;
+    }
+
+    void print_usage(const char* program)
+    {
+        std::cerr << "usage: " << program << " [--moves N] [--nodes N] [--movetime MS] [--threads N] [file]\n"
+                  << "Reads one FEN or EPD per line (stdin without a file) and prints the\n"
+                  << "shortest forced mate for the side to move. An EPD \"dm N\" opcode\n"
+                  << "sets the mate length to look for and is checked against the result.\n"
+                  << "Puzzles are solved in parallel, on every core unless --threads says\n"
+                  << "otherwise; results are printed in input order.\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    MateLimits defaults;
+    int threads = 0;
+    const char* path = nullptr;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg(argv[i]);
+        if (arg == "--moves" && i + 1 < argc)
+        {
+            defaults.maxMoves = std::atoi(argv[++i]);
+        }
+        else if (arg == "--nodes" && i + 1 < argc)
+        {
+            defaults.maxNodes = std::atoll(argv[++i]);
+        }
+        else if (arg == "--movetime" && i + 1 < argc)
+        {
+            defaults.timeLimitMs = std::atoi(argv[++i]);
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            threads = std::atoi(argv[++i]);
+        }
+        else if (arg == "--help" || arg == "-h" || path != nullptr)
+        {
+            print_usage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+        else
+        {
+            path = argv[i];
+        }
+    }
+
+    std::ifstream file;
+    if (path != nullptr)
+    {
+        file.open(path);
+        if (!file)
+        {
+            std::cerr << "cannot open " << path << '\n';
+            return 1;
+        }
+    }
+    std::istream& in = (path != nullptr) ? static_cast<std::istream&>(file) : std::cin;
+
+    using Clock = std::chrono::steady_clock;
+    const auto batchStart = Clock::now();
+
+    std::vector<Puzzle> puzzles;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        Puzzle puzzle;
+        if (parse_puzzle(line, puzzle))
+        {
+            puzzles.push_back(std::move(puzzle));
+        }
+    }
+
+    // One solver per pool thread, each with its own proof table, created
+    // by the thread on its first puzzle.
+    ThreadPool pool(threads);
+    std::vector<std::unique_ptr<MateSolver>> solvers(static_cast<std::size_t>(pool.size()));
+    std::vector<Outcome> outcomes(puzzles.size());
+    pool.parallel_for(0, puzzles.size(),
+                      [&](std::size_t i)
+                      {
+                          std::unique_ptr<MateSolver>& solver =
+                              solvers[static_cast<std::size_t>(pool.thread_index())];
+                          if (!solver)
+                          {
+                              solver = std::make_unique<MateSolver>();
+                          }
+                          outcomes[i] = solve_puzzle(*solver, puzzles[i], defaults);
+                      });
+
+    const int total = static_cast<int>(puzzles.size());
+    int solved = 0;
+    int mismatched = 0;
+    std::int64_t totalNodes = 0;
+    for (std::size_t i = 0; i < outcomes.size(); ++i)
+    {
+        const Outcome& outcome = outcomes[i];
+        solved += outcome.solved ? 1 : 0;
+        mismatched += outcome.mismatched ? 1 : 0;
+        totalNodes += outcome.nodes;
+        std::cout << i + 1 << ": " << outcome.text << '\n';
+    }
+
+    const auto totalMs =
+        std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - batchStart).count();
+    std::cout << "solved " << solved << '/' << total;
+    if (mismatched > 0)
+    {
+        std::cout << ", " << mismatched << " shorter than expected";
+    }
+    std::cout << ", nodes " << totalNodes << ", " << totalMs << "ms\n";
+    return (solved == total) ? 0 : 2;
+}
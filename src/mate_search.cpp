@@ -0,0 +1,276 @@
+#include "mate_search.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "board.h"
+
+namespace
+{
+    constexpr std::uint32_t Infinite = std::numeric_limits<std::uint32_t>::max() / 2;
+    constexpr int MaxMateMoves = 100;
+    constexpr std::int64_t LimitCheckInterval = 1024;
+
+    std::uint32_t saturating_add(std::uint32_t a, std::uint32_t b)
+    {
+        return static_cast<std::uint32_t>(
+            std::min<std::uint64_t>(std::uint64_t{a} + b, Infinite));
+    }
+
+    bool find_packed_move(const Board& board, std::uint16_t packed, Move& out)
+    {
+        for (const Move& move : board.generate_legal_moves())
+        {
+            if (pack_move(move) == packed)
+            {
+                out = move;
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+MateSolver::MateSolver(std::size_t entries)
+    : table_(std::max<std::size_t>(entries, 1))
+{
+}
+
+void MateSolver::clear() noexcept
+{
+    std::fill(table_.begin(), table_.end(), Entry{});
+}
+
+std::size_t MateSolver::index_of(std::uint64_t key, int remaining) const noexcept
+{
+    const std::uint64_t mixed = key ^ (static_cast<std::uint64_t>(remaining) * 0x9E3779B97F4A7C15ULL);
+    return static_cast<std::size_t>(mixed % table_.size());
+}
+
+const MateSolver::Entry* MateSolver::lookup(std::uint64_t key, int remaining) const noexcept
+{
+    const Entry& entry = table_[index_of(key, remaining)];
+    if (!entry.used || entry.key != key || entry.remaining != remaining)
+    {
+        return nullptr;
+    }
+    return &entry;
+}
+
+void MateSolver::store(std::uint64_t key,
+                       int remaining,
+                       std::uint32_t phi,
+                       std::uint32_t delta,
+                       std::uint16_t move) noexcept
+{
+    Entry& entry = table_[index_of(key, remaining)];
+    entry.key = key;
+    entry.phi = phi;
+    entry.delta = delta;
+    entry.move = move;
+    entry.remaining = static_cast<std::uint8_t>(remaining);
+    entry.used = true;
+}
+
+bool MateSolver::limit_reached()
+{
+    if (aborted_)
+    {
+        return true;
+    }
+    if (nodes_ % LimitCheckInterval != 0)
+    {
+        return false;
+    }
+
+    if ((limits_.maxNodes > 0 && nodes_ >= limits_.maxNodes) ||
+        (limits_.stop != nullptr && limits_.stop->load(std::memory_order_relaxed)))
+    {
+        aborted_ = true;
+    }
+    else if (limits_.timeLimitMs > 0)
+    {
+        const auto elapsed = std::chrono::steady_clock::now() - startTime_;
+        aborted_ = elapsed >= std::chrono::milliseconds(limits_.timeLimitMs);
+    }
+    return aborted_;
+}
+
+// One df-pn node. `remaining` counts plies left for the attacker's mate;
+// the attacker moves at odd values, the defender at even ones.
+void MateSolver::search_node(Board& board,
+                             int remaining,
+                             bool attacker,
+                             std::uint32_t phiThreshold,
+                             std::uint32_t deltaThreshold)
+{
+    ++nodes_;
+    const std::uint64_t key = board.zobrist_key();
+    const std::vector<Move> moves = board.generate_legal_moves();
+
+    if (moves.empty())
+    {
+        // Stalemate saves the defender; an attacker without moves has failed.
+        const bool sideToMoveLoses = attacker || board.is_in_check(board.side_to_move());
+        store(key, remaining, sideToMoveLoses ? Infinite : 0, sideToMoveLoses ? 0 : Infinite, 0);
+        return;
+    }
+    if (!attacker && remaining == 0)
+    {
+        // The attacker is out of moves and this is not mate.
+        store(key, remaining, 0, Infinite, 0);
+        return;
+    }
+
+    std::vector<std::uint64_t> childKeys;
+    childKeys.reserve(moves.size());
+    for (const Move& move : moves)
+    {
+        board.make_move(move);
+        childKeys.push_back(board.zobrist_key());
+        board.undo_move();
+    }
+
+    while (true)
+    {
+        // phi = min child delta, delta = sum of child phi; unexplored
+        // children count as (1, 1).
+        std::uint32_t minDelta = Infinite;
+        std::uint32_t secondDelta = Infinite;
+        std::uint32_t sumPhi = 0;
+        std::uint32_t bestPhi = 1;
+        std::size_t best = 0;
+        for (std::size_t i = 0; i < moves.size(); ++i)
+        {
+            const Entry* child = lookup(childKeys[i], remaining - 1);
+            const std::uint32_t childPhi = child != nullptr ? child->phi : 1;
+            const std::uint32_t childDelta = child != nullptr ? child->delta : 1;
+
+            sumPhi = saturating_add(sumPhi, childPhi);
+            if (childDelta < minDelta)
+            {
+                secondDelta = minDelta;
+                minDelta = childDelta;
+                bestPhi = childPhi;
+                best = i;
+            }
+            else if (childDelta < secondDelta)
+            {
+                secondDelta = childDelta;
+            }
+        }
+
+        const std::uint32_t phi = minDelta;
+        const std::uint32_t delta = sumPhi;
+        if (phi >= phiThreshold || delta >= deltaThreshold || limit_reached())
+        {
+            store(key, remaining, phi, delta, pack_move(moves[best]));
+            return;
+        }
+
+        const std::uint32_t childPhiThreshold =
+            saturating_add(deltaThreshold - delta, bestPhi);
+        const std::uint32_t childDeltaThreshold =
+            std::min(phiThreshold, saturating_add(secondDelta, 1));
+
+        board.make_move(moves[best]);
+        search_node(board, remaining - 1, !attacker, childPhiThreshold, childDeltaThreshold);
+        board.undo_move();
+    }
+}
+
+int MateSolver::mate_distance(Board& board, int maxPlies)
+{
+    const std::uint64_t key = board.zobrist_key();
+    for (int plies = 1; plies < maxPlies && !aborted_; plies += 2)
+    {
+        const Entry* entry = lookup(key, plies);
+        if (entry == nullptr || (entry->phi != 0 && entry->delta != 0))
+        {
+            search_node(board, plies, true, Infinite, Infinite);
+            entry = lookup(key, plies);
+        }
+        if (entry != nullptr && entry->phi == 0)
+        {
+            return plies;
+        }
+    }
+    return maxPlies;
+}
+
+MateResult MateSolver::solve(Board& board, const MateLimits& limits)
+{
+    limits_ = limits;
+    nodes_ = 0;
+    aborted_ = false;
+    startTime_ = std::chrono::steady_clock::now();
+
+    MateResult result;
+    const int maxMoves = std::clamp(limits.maxMoves, 0, MaxMateMoves);
+    for (int mateIn = 1; mateIn <= maxMoves && !aborted_; ++mateIn)
+    {
+        const int plies = 2 * mateIn - 1;
+        search_node(board, plies, true, Infinite, Infinite);
+
+        const Entry* root = lookup(board.zobrist_key(), plies);
+        if (aborted_ || root == nullptr || root->phi != 0)
+        {
+            continue;
+        }
+
+        result.found = true;
+        result.mateIn = mateIn;
+
+        // Walk down the proof tree with best play from both sides: the
+        // attacker takes its shortest proven mate, the defender the reply
+        // that holds out longest, so the line is exactly `plies` long.
+        int remaining = plies;
+        bool attacker = true;
+        while (remaining > 0)
+        {
+            Move move;
+            if (attacker)
+            {
+                remaining = mate_distance(board, remaining);
+                const Entry* entry = lookup(board.zobrist_key(), remaining);
+                if (entry == nullptr || entry->move == 0 || !find_packed_move(board, entry->move, move))
+                {
+                    break;
+                }
+            }
+            else
+            {
+                const std::vector<Move> replies = board.generate_legal_moves();
+                if (replies.empty())
+                {
+                    break;
+                }
+                int longest = -1;
+                for (const Move& reply : replies)
+                {
+                    board.make_move(reply);
+                    const int distance = mate_distance(board, remaining - 1);
+                    board.undo_move();
+                    if (distance > longest)
+                    {
+                        longest = distance;
+                        move = reply;
+                    }
+                }
+            }
+            result.pv.push_back(move);
+            board.make_move(move);
+            --remaining;
+            attacker = !attacker;
+        }
+        for (std::size_t i = 0; i < result.pv.size(); ++i)
+        {
+            board.undo_move();
+        }
+        break;
+    }
+
+    result.nodes = nodes_;
+    result.aborted = aborted_;
+    return result;
+}
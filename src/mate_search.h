@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "move.h"
+
+class Board;
+
+struct MateLimits
+{
+    // Longest mate to look for, in moves of the side to move.
+    int maxMoves{5};
+    // 0 means unlimited.
+    std::int64_t maxNodes{0};
+    int timeLimitMs{0};
+    const std::atomic<bool>* stop{nullptr};
+};
+
+struct MateResult
+{
+    bool found{false};
+    // Moves of the side to move until mate; 0 when nothing was found.
+    int mateIn{0};
+    // Mating line, attacker's move first; ends in mate.
+    std::vector<Move> pv{};
+    std::int64_t nodes{0};
+    // Set when a limit cut the search short, so "not found" is not a proof.
+    bool aborted{false};
+};
+
+// Depth-first proof-number (df-pn) search for forced mates by the side to
+// move. Unlike alpha-beta it only asks "is this a forced mate within N?",
+// expanding the most promising proof first, which proves most mates in far
+// fewer nodes. Solves for mate in 1, 2, ... up to the limit, so the first
+// proof found is the shortest. Proof and disproof numbers are kept in the
+// solver's own table, keyed by position and remaining depth, and stay valid
+// across solves until clear().
+class MateSolver
+{
+public:
+    static constexpr std::size_t DefaultEntries = std::size_t{1} << 20;
+
+    explicit MateSolver(std::size_t entries = DefaultEntries);
+
+    MateResult solve(Board& board, const MateLimits& limits);
+    void clear() noexcept;
+
+private:
+    // Proof state from the side to move's point of view: phi is the
+    // proof number of "side to move wins", delta that of "side to move
+    // loses". phi == 0 is a proven win, delta == 0 a proven loss.
+    struct Entry
+    {
+        std::uint64_t key{0};
+        std::uint32_t phi{0};
+        std::uint32_t delta{0};
+        std::uint16_t move{0};
+        std::uint8_t remaining{0};
+        bool used{false};
+    };
+
+    void search_node(Board& board, int remaining, bool attacker,
+                     std::uint32_t phiThreshold, std::uint32_t deltaThreshold);
+    bool limit_reached();
+    // Fewest odd plies, up to maxPlies, in which the attacker to move
+    // mates; maxPlies when none is proven before a limit hits.
+    int mate_distance(Board& board, int maxPlies);
+
+    [[nodiscard]] const Entry* lookup(std::uint64_t key, int remaining) const noexcept;
+    void store(std::uint64_t key, int remaining,
+               std::uint32_t phi, std::uint32_t delta, std::uint16_t move) noexcept;
+    [[nodiscard]] std::size_t index_of(std::uint64_t key, int remaining) const noexcept;
+
+    std::vector<Entry> table_;
+    MateLimits limits_{};
+    std::int64_t nodes_{0};
+    bool aborted_{false};
+    std::chrono::steady_clock::time_point startTime_{};
+};
@@ -0,0 +1,237 @@
+#include "material.h"
+
+#include <algorithm>
+
+#include "attack_tables.h"
+#include "board.h"
+
+namespace
+{
+    constexpr int KnightValue = 320;
+    constexpr int BishopValue = 330;
+    constexpr int RookValue = 500;
+    constexpr int QueenValue = 900;
+
+    // Far above any positional score, far below a mate score.
+    constexpr int KnownWin = 10000;
+
+    constexpr Score BishopPair(30, 50);
+    constexpr int OppositeBishopsScale = 32;
+
+    struct SideCounts
+    {
+        int pawns{0};
+        int knights{0};
+        int bishops{0};
+        int rooks{0};
+        int queens{0};
+        int kings{0};
+
+        [[nodiscard]] int non_pawn_material() const
+        {
+            return knights * KnightValue + bishops * BishopValue + rooks * RookValue + queens * QueenValue;
+        }
+
+        [[nodiscard]] bool bare() const
+        {
+            return pawns + knights + bishops + rooks + queens == 0;
+        }
+    };
+
+    SideCounts count_side(const Position& position, Color side)
+    {
+        SideCounts counts;
+        counts.pawns = position.piece_count(colored_piece(Piece::WhitePawn, side));
+        counts.knights = position.piece_count(colored_piece(Piece::WhiteKnight, side));
+        counts.bishops = position.piece_count(colored_piece(Piece::WhiteBishop, side));
+        counts.rooks = position.piece_count(colored_piece(Piece::WhiteRook, side));
+        counts.queens = position.piece_count(colored_piece(Piece::WhiteQueen, side));
+        counts.kings = position.piece_count(colored_piece(Piece::WhiteKing, side));
+        return counts;
+    }
+
+    // a1, c1, ..., b2, d2, ...: the squares dark_square() is true for.
+    constexpr Bitboard DarkSquares = 0xAA55AA55AA55AA55ULL;
+
+    bool dark_square(int square)
+    {
+        return ((file_of(square) + rank_of(square)) & 1) == 0;
+    }
+
+    // 120 in a corner down to 0 in the centre.
+    int push_to_edge(int square)
+    {
+        const int file = std::min(file_of(square), 7 - file_of(square));
+        const int rank = std::min(rank_of(square), 7 - rank_of(square));
+        return 20 * (6 - file - rank);
+    }
+
+    int push_close(int a, int b)
+    {
+        return 10 * (7 - SquareDistance[static_cast<std::size_t>(a)][static_cast<std::size_t>(b)]);
+    }
+
+    int evaluate_draw(const Board&, Color)
+    {
+        return 0;
+    }
+
+    // Lone king against mating material: drive it to the edge and bring
+    // the kings together, which is all the mating technique needs.
+    int evaluate_kxk(const Board& board, Color strongSide)
+    {
+        const int strongKing = board.king_square(strongSide);
+        const int weakKing = board.king_square(opposite_color(strongSide));
+        const int material =
+            board.piece_count(colored_piece(Piece::WhitePawn, strongSide)) * 100 +
+            board.piece_count(colored_piece(Piece::WhiteKnight, strongSide)) * KnightValue +
+            board.piece_count(colored_piece(Piece::WhiteBishop, strongSide)) * BishopValue +
+            board.piece_count(colored_piece(Piece::WhiteRook, strongSide)) * RookValue +
+            board.piece_count(colored_piece(Piece::WhiteQueen, strongSide)) * QueenValue;
+        return KnownWin + material + push_to_edge(weakKing) + push_close(strongKing, weakKing);
+    }
+
+    // Bishops alone mate only when they stand on both colors; any number of
+    // them on one color never can. Which it is depends on placement, which
+    // the material key leaves out, so it is decided here.
+    int evaluate_kbbk(const Board& board, Color strongSide)
+    {
+        const Bitboard bishops = board.pieces(colored_piece(Piece::WhiteBishop, strongSide));
+        if ((bishops & DarkSquares) == 0 || (bishops & ~DarkSquares) == 0)
+        {
+            return 0;
+        }
+        return evaluate_kxk(board, strongSide);
+    }
+
+    // Bishop and knight mate only in a corner of the bishop's color.
+    int evaluate_kbnk(const Board& board, Color strongSide)
+    {
+        const int strongKing = board.king_square(strongSide);
+        const int weakKing = board.king_square(opposite_color(strongSide));
+        const int bishop = lsb(board.pieces(colored_piece(Piece::WhiteBishop, strongSide)));
+        const bool dark = dark_square(bishop);
+        const auto& distance = SquareDistance[static_cast<std::size_t>(weakKing)];
+        const int cornerDistance = dark ? std::min(distance[0], distance[63]) : std::min(distance[7], distance[56]);
+        return KnownWin + KnightValue + BishopValue + 20 * (7 - cornerDistance) +
+               push_close(strongKing, weakKing);
+    }
+
+    // One bishop each and nothing else but pawns: on opposite colors even
+    // a pawn or two up is often a draw.
+    int scale_opposite_bishops(const Board& board)
+    {
+        const Bitboard white = board.pieces(Piece::WhiteBishop);
+        const Bitboard black = board.pieces(Piece::BlackBishop);
+        return dark_square(lsb(white)) != dark_square(lsb(black)) ? OppositeBishopsScale : NormalScale;
+    }
+
+    MaterialEntry analyse(const Position& position)
+    {
+        MaterialEntry entry;
+        const SideCounts sides[2] = {count_side(position, Color::White), count_side(position, Color::Black)};
+        const SideCounts& white = sides[0];
+        const SideCounts& black = sides[1];
+
+        const int phase = (white.knights + black.knights + white.bishops + black.bishops) +
+                          2 * (white.rooks + black.rooks) + 4 * (white.queens + black.queens);
+        entry.phase = std::clamp(phase, 0, MaxPhase);
+
+        if (white.bishops >= 2)
+        {
+            entry.imbalance += BishopPair;
+        }
+        if (black.bishops >= 2)
+        {
+            entry.imbalance -= BishopPair;
+        }
+
+        // Specialised endgames assume exactly one king a side.
+        if (white.kings != 1 || black.kings != 1)
+        {
+            return entry;
+        }
+
+        const bool noPawns = white.pawns == 0 && black.pawns == 0;
+        if (noPawns && white.non_pawn_material() <= BishopValue && black.non_pawn_material() <= BishopValue)
+        {
+            entry.evaluate = evaluate_draw;
+            return entry;
+        }
+
+        for (const Color side : {Color::White, Color::Black})
+        {
+            const SideCounts& strong = sides[static_cast<std::size_t>(side)];
+            const SideCounts& weak = sides[static_cast<std::size_t>(opposite_color(side))];
+            if (!weak.bare())
+            {
+                continue;
+            }
+
+            entry.strongSide = side;
+            if (strong.pawns == 0 && strong.knights == 2 && strong.non_pawn_material() == 2 * KnightValue)
+            {
+                entry.evaluate = evaluate_draw;
+                return entry;
+            }
+            if (strong.pawns == 0 && strong.knights == 1 && strong.bishops == 1 &&
+                strong.rooks + strong.queens == 0)
+            {
+                entry.evaluate = evaluate_kbnk;
+                return entry;
+            }
+            if (strong.pawns == 0 && strong.bishops >= 2 &&
+                strong.non_pawn_material() == strong.bishops * BishopValue)
+            {
+                entry.evaluate = evaluate_kbbk;
+                return entry;
+            }
+            if (strong.queens + strong.rooks > 0 || strong.bishops >= 2 ||
+                (strong.bishops >= 1 && strong.knights >= 1))
+            {
+                entry.evaluate = evaluate_kxk;
+                return entry;
+            }
+        }
+
+        // Without pawns a side needs more than a minor piece's worth of extra
+        // material to win.
+        for (const Color side : {Color::White, Color::Black})
+        {
+            const SideCounts& strong = sides[static_cast<std::size_t>(side)];
+            const SideCounts& weak = sides[static_cast<std::size_t>(opposite_color(side))];
+            if (strong.pawns == 0 && strong.non_pawn_material() - weak.non_pawn_material() <= BishopValue)
+            {
+                entry.scaleFactor[static_cast<std::size_t>(side)] =
+                    strong.non_pawn_material() < RookValue  ? 0
+                    : weak.non_pawn_material() <= BishopValue ? 4
+                                                              : 14;
+            }
+        }
+
+        if (white.bishops == 1 && black.bishops == 1 &&
+            white.non_pawn_material() == BishopValue && black.non_pawn_material() == BishopValue)
+        {
+            entry.scale = scale_opposite_bishops;
+        }
+
+        return entry;
+    }
+}
+
+MaterialTable::MaterialTable(std::size_t entries)
+    : entries_(std::max<std::size_t>(entries, 1))
+{
+}
+
+const MaterialEntry& MaterialTable::probe(const Position& position)
+{
+    const std::uint64_t key = position.material_key();
+    MaterialEntry& entry = entries_[key % entries_.size()];
+    if (entry.key != key)
+    {
+        entry = analyse(position);
+        entry.key = key;
+    }
+    return entry;
+}
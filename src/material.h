@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "position.h"
+#include "score.h"
+
+class Board;
+
+// Game phase from the non-pawn material: MaxPhase with all pieces on the
+// board, 0 once only kings and pawns are left.
+inline constexpr int MaxPhase = 24;
+// Endgame scale factors are fractions of NormalScale.
+inline constexpr int NormalScale = 64;
+
+// Replaces the general evaluation of a recognised endgame; the score is in
+// centipawns from `strongSide`'s point of view.
+using EndgameFunction = int (*)(const Board& board, Color strongSide);
+// Scale factor, 0..NormalScale, for the endgame score of a position whose
+// material alone does not settle it.
+using ScaleFunction = int (*)(const Board& board);
+
+// Everything evaluate() can derive from the piece counts alone.
+struct MaterialEntry
+{
+    std::uint64_t key{0};
+    int phase{0};
+    // Material-only adjustments, from white's point of view.
+    Score imbalance{};
+    // Set for endgames whose result is known from the material.
+    EndgameFunction evaluate{nullptr};
+    Color strongSide{Color::White};
+    ScaleFunction scale{nullptr};
+    // Applied to the endgame score when that color, indexed by Color, is
+    // ahead in it.
+    std::uint8_t scaleFactor[2]{NormalScale, NormalScale};
+};
+
+// Caches MaterialEntry by Position::material_key(). A handful of entries
+// cover a whole search, since captures rarely change the material mix.
+class MaterialTable
+{
+public:
+    static constexpr std::size_t DefaultEntries = 8192;
+
+    explicit MaterialTable(std::size_t entries = DefaultEntries);
+
+    const MaterialEntry& probe(const Position& position);
+
+private:
+    std::vector<MaterialEntry> entries_;
+};
@@ -1,6 +1,5 @@
 #include "move.h"
 
-#include <cassert>
 #include <cctype>
 
 #include "board.h"
@@ -58,23 +57,18 @@ std::string Move::to_uci() const
     return result;
 }
 
-int file_of(int square)
+std::uint16_t pack_move(const Move& move)
 {
-    assert(square >= 0 && square < 64);
-    return square % 8;
-}
+    if (move.movingPiece == Piece::None)
+    {
+        return 0;
+    }
 
-int rank_of(int square)
-{
-    assert(square >= 0 && square < 64);
-    return square / 8;
-}
+    // Knight..Queen sit at the same offsets in both colors' ranges.
+    const int promotion =
+        (move.promotionPiece == Piece::None) ? 0 : (static_cast<int>(move.promotionPiece) - 1) % 6;
 
-int make_square(int file, int rank)
-{
-    assert(file >= 0 && file < 8);
-    assert(rank >= 0 && rank < 8);
-    return rank * 8 + file;
+    return static_cast<std::uint16_t>(move.from | (move.to << 6) | (promotion << 12));
 }
 
 std::string square_to_string(int square)
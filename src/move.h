@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cassert>
 #include <cstdint>
 #include <string>
 
@@ -37,9 +38,30 @@ struct Move
     [[nodiscard]] std::string to_uci() const;
 };
 
-int file_of(int square);
-int rank_of(int square);
-int make_square(int file, int rank);
+constexpr int file_of(int square)
+{
+    assert(square >= 0 && square < 64);
+    return square & 7;
+}
+
+constexpr int rank_of(int square)
+{
+    assert(square >= 0 && square < 64);
+    return square >> 3;
+}
+
+constexpr int make_square(int file, int rank)
+{
+    assert(file >= 0 && file < 8);
+    assert(rank >= 0 && rank < 8);
+    return (rank << 3) | file;
+}
+
+// 16-bit move id: from | to << 6 | promotion << 12, where promotion is
+// 0 for none and 1..4 for knight, bishop, rook, queen. Zero is never a legal
+// move, so it doubles as "no move".
+std::uint16_t pack_move(const Move& move);
+
 std::string square_to_string(int square);
 int square_from_string(const std::string& name);
 
@@ -4,12 +4,12 @@
 #include <string>
 #include <vector>
 
-#include "board.h"
+#include "position.h"
 #include "move.h"
 
 namespace
 {
-    bool is_castling(const Move& move, const Board& board)
+    bool is_castling(const Move& move, const Position& board)
     {
         const Piece king = (board.side_to_move() == Color::White) ? Piece::WhiteKing : Piece::BlackKing;
         if (move.movingPiece != king)
@@ -55,16 +55,9 @@ namespace
         return typeA == typeB;
     }
 
-    bool causes_check(Board& board, const Move& move)
+    bool causes_mate(const Position& board, const Move& move)
     {
-        Board copy = board;
-        copy.make_move(move);
-        return copy.is_in_check(copy.side_to_move());
-    }
-
-    bool causes_mate(Board& board, const Move& move)
-    {
-        Board copy = board;
+        Position copy = board;
         copy.make_move(move);
         if (!copy.is_in_check(copy.side_to_move()))
         {
@@ -75,7 +68,7 @@ namespace
     }
 }
 
-std::string move_to_san(Board& positionBeforeMove, const Move& move)
+std::string move_to_san(const Position& positionBeforeMove, const Move& move)
 {
     if (is_castling(move, positionBeforeMove))
     {
@@ -160,13 +153,9 @@ std::string move_to_san(Board& positionBeforeMove, const Move& move)
         san += piece_letter(move.promotionPiece);
     }
 
-    if (causes_mate(positionBeforeMove, move))
-    {
-        san += '#';
-    }
-    else if (causes_check(positionBeforeMove, move))
+    if (positionBeforeMove.gives_check(move))
     {
-        san += '+';
+        san += causes_mate(positionBeforeMove, move) ? '#' : '+';
     }
 
     return san;
@@ -2,7 +2,7 @@
 
 #include <string>
 
-class Board;
+class Position;
 struct Move;
 
-std::string move_to_san(Board& positionBeforeMove, const Move& move);
+std::string move_to_san(const Position& positionBeforeMove, const Move& move);
@@ -0,0 +1,193 @@
+#include "perf_counters.h"
+
+#include <cstdio>
+
+#if defined(__linux__)
+
+#include <cerrno>
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr std::uint64_t cache_event(std::uint64_t cache, std::uint64_t result)
+    {
+        return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (result << 16);
+    }
+
+    struct EventConfig
+    {
+        std::uint32_t type;
+        std::uint64_t config;
+    };
+
+    constexpr EventConfig Events[PerfEventCount] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+        {PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_RESULT_MISS)}};
+
+    // Value, then the times the event was enabled and actually counting;
+    // they differ when the kernel multiplexes more events than the PMU has
+    // counters.
+    struct ReadFormat
+    {
+        std::uint64_t value;
+        std::uint64_t timeEnabled;
+        std::uint64_t timeRunning;
+    };
+
+    int open_event(const EventConfig& event)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = event.type;
+        attr.config = event.config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.inherit = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+}
+
+PerfCounters::~PerfCounters()
+{
+    close_all();
+}
+
+void PerfCounters::close_all() noexcept
+{
+    for (int& fd : fds_)
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+}
+
+bool PerfCounters::open(std::string& error)
+{
+    for (std::size_t i = 0; i < PerfEventCount; ++i)
+    {
+        if (fds_[i] < 0)
+        {
+            fds_[i] = open_event(Events[i]);
+        }
+        if (fds_[i] < 0 && (i == PerfCycles || i == PerfInstructions))
+        {
+            error = std::string("perf_event_open: ") + std::strerror(errno);
+            close_all();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PerfCounters::is_open() const noexcept
+{
+    return fds_[PerfCycles] >= 0 && fds_[PerfInstructions] >= 0;
+}
+
+void PerfCounters::start() noexcept
+{
+    for (const int fd : fds_)
+    {
+        if (fd >= 0)
+        {
+            ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+PerfSample PerfCounters::stop() noexcept
+{
+    PerfSample sample;
+    for (std::size_t i = 0; i < PerfEventCount; ++i)
+    {
+        const int fd = fds_[i];
+        if (fd < 0)
+        {
+            continue;
+        }
+        ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+        ReadFormat data{};
+        if (::read(fd, &data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data.timeRunning == 0)
+        {
+            continue;
+        }
+        const double scale = static_cast<double>(data.timeEnabled) / static_cast<double>(data.timeRunning);
+        sample.values[i] = static_cast<std::uint64_t>(static_cast<double>(data.value) * scale);
+        sample.counted[i] = true;
+    }
+    return sample;
+}
+
+#else
+
+PerfCounters::~PerfCounters() = default;
+
+void PerfCounters::close_all() noexcept
+{
+}
+
+bool PerfCounters::open(std::string& error)
+{
+    error = "hardware counters need Linux perf_event_open";
+    return false;
+}
+
+bool PerfCounters::is_open() const noexcept
+{
+    return false;
+}
+
+void PerfCounters::start() noexcept
+{
+}
+
+PerfSample PerfCounters::stop() noexcept
+{
+    return PerfSample{};
+}
+
+#endif
+
+std::string format_perf_sample(const PerfSample& sample, std::uint64_t units, const char* unit)
+{
+    static constexpr const char* Names[PerfEventCount] = {
+        "cycles", "instr", "branch-miss", "L1d-miss", "LLC-miss"};
+
+    std::string text;
+    char buffer[64];
+    const double divisor = static_cast<double>(units > 0 ? units : 1);
+    for (std::size_t i = 0; i < PerfEventCount; ++i)
+    {
+        if (!sample.counted[i])
+        {
+            continue;
+        }
+        std::snprintf(buffer, sizeof(buffer), "%s%s/%s %.1f", text.empty() ? "" : " ", Names[i], unit,
+                      static_cast<double>(sample.values[i]) / divisor);
+        text += buffer;
+        if (i == PerfInstructions && sample.counted[PerfCycles] && sample.values[PerfCycles] > 0)
+        {
+            std::snprintf(buffer, sizeof(buffer), " IPC %.2f",
+                          static_cast<double>(sample.values[PerfInstructions]) /
+                              static_cast<double>(sample.values[PerfCycles]));
+            text += buffer;
+        }
+    }
+    return text;
+}
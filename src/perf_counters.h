@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum PerfEvent : std::size_t
+{
+    PerfCycles,
+    PerfInstructions,
+    PerfBranchMisses,
+    PerfL1dMisses,
+    PerfLlcMisses,
+    PerfEventCount
+};
+
+// Event counts over one start()/stop() stretch. An event the machine could
+// not count is left out rather than reported as zero.
+struct PerfSample
+{
+    std::array<std::uint64_t, PerfEventCount> values{};
+    std::array<bool, PerfEventCount> counted{};
+};
+
+// Hardware counters of the calling thread and the threads it starts after
+// open(), user space only, read through Linux perf_event_open(). Elsewhere,
+// or when the kernel refuses (no PMU under a hypervisor,
+// perf_event_paranoid above 2), open() fails and the benchmarks fall back
+// to wall clock alone.
+class PerfCounters
+{
+public:
+    PerfCounters() = default;
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Opens every event the machine supports. Returns false, with nothing
+    // left open, and sets `error` when not even cycles and instructions can
+    // be counted.
+    bool open(std::string& error);
+    // True after a successful open().
+    [[nodiscard]] bool is_open() const noexcept;
+
+    void start() noexcept;
+    PerfSample stop() noexcept;
+
+private:
+    void close_all() noexcept;
+
+    std::array<int, PerfEventCount> fds_{-1, -1, -1, -1, -1};
+};
+
+// "cycles/node 812.4 instr/node 1503.2 IPC 1.85 ..." for the counted
+// events, divided by `units` of work named `unit`.
+std::string format_perf_sample(const PerfSample& sample, std::uint64_t units, const char* unit);
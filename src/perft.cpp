@@ -1,32 +1,72 @@
 #include <cstdint>
+#include <cstdlib>
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include "board.h"
 #include "move.h"
+#include "perf_counters.h"
+#include "thread_pool.h"
 
-std::uint64_t perft(Board& board, int depth)
+// Counts each root move's subtree on its own copy of the board.
+std::uint64_t parallel_perft(ThreadPool& pool, const Board& board, int depth)
 {
-    if (depth == 0)
+    if (depth <= 1)
     {
-        return 1;
+        Board copy = board;
+        return perft(copy, depth);
     }
 
-    std::uint64_t nodes = 0;
     const std::vector<Move> moves = board.generate_legal_moves();
+    std::vector<std::uint64_t> counts(moves.size(), 0);
+    pool.parallel_for(0, moves.size(),
+                      [&](std::size_t i)
+                      {
+                          Board copy = board;
+                          copy.make_move(moves[i]);
+                          counts[i] = perft(copy, depth - 1);
+                      });
 
-    for (const Move& move : moves)
+    std::uint64_t nodes = 0;
+    for (const std::uint64_t count : counts)
     {
-        board.make_move(move);
-        nodes += perft(board, depth - 1);
-        board.undo_move();
+        nodes += count;
     }
-
     return nodes;
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+    int threads = 0;
+    bool showCounters = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg(argv[i]);
+        if (arg == "--threads" && i + 1 < argc)
+        {
+            threads = std::atoi(argv[++i]);
+        }
+        else if (arg == "--counters")
+        {
+            showCounters = true;
+        }
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--threads N] [--counters]\n";
+            return 1;
+        }
+    }
+
+    // Opened before the pool starts so the workers are counted too.
+    PerfCounters counters;
+    std::string error;
+    if (showCounters && !counters.open(error))
+    {
+        std::cerr << "hardware counters unavailable: " << error << '\n';
+    }
+
+    ThreadPool pool(threads);
     Board board;
 
     std::cout << "Perft for standard starting position:\n";
@@ -37,9 +77,15 @@ int main()
     for (std::size_t i = 0; i < 4; ++i)
     {
         const int depth = depths[i];
-        std::uint64_t nodes = perft(board, depth);
+        counters.start();
+        std::uint64_t nodes = parallel_perft(pool, board, depth);
+        const PerfSample sample = counters.stop();
         std::cout << "Depth " << depth << ": " << nodes
                   << " (expected " << expected[i] << ")\n";
+        if (counters.is_open())
+        {
+            std::cout << "    " << format_perf_sample(sample, nodes, "node") << '\n';
+        }
     }
 
     return 0;
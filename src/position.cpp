@@ -0,0 +1,1439 @@
+#include "position.h"
+
+#include <algorithm>
+#include <charconv>
+
+#include "attack_tables.h"
+#include "move.h"
+#include "zobrist.h"
+
+namespace
+{
+    constexpr std::uint8_t CastleWhiteKing = 1 << 0;
+    constexpr std::uint8_t CastleWhiteQueen = 1 << 1;
+    constexpr std::uint8_t CastleBlackKing = 1 << 2;
+    constexpr std::uint8_t CastleBlackQueen = 1 << 3;
+
+    constexpr Piece piece_from_char(char symbol)
+    {
+        switch (symbol)
+        {
+        case 'P': return Piece::WhitePawn;
+        case 'N': return Piece::WhiteKnight;
+        case 'B': return Piece::WhiteBishop;
+        case 'R': return Piece::WhiteRook;
+        case 'Q': return Piece::WhiteQueen;
+        case 'K': return Piece::WhiteKing;
+        case 'p': return Piece::BlackPawn;
+        case 'n': return Piece::BlackKnight;
+        case 'b': return Piece::BlackBishop;
+        case 'r': return Piece::BlackRook;
+        case 'q': return Piece::BlackQueen;
+        case 'k': return Piece::BlackKing;
+        default:  return Piece::None;
+        }
+    }
+
+    // Placement characters: a piece advances one file, a digit skips that
+    // many. Everything else, including '/', has advance 0.
+    struct FenSymbol
+    {
+        Piece piece{Piece::None};
+        std::uint8_t advance{0};
+    };
+
+    constexpr std::array<FenSymbol, 256> make_fen_symbols()
+    {
+        std::array<FenSymbol, 256> table{};
+        for (char digit = '1'; digit <= '8'; ++digit)
+        {
+            table[static_cast<unsigned char>(digit)] =
+                FenSymbol{Piece::None, static_cast<std::uint8_t>(digit - '0')};
+        }
+        for (char symbol : {'P', 'N', 'B', 'R', 'Q', 'K', 'p', 'n', 'b', 'r', 'q', 'k'})
+        {
+            table[static_cast<unsigned char>(symbol)] = FenSymbol{piece_from_char(symbol), 1};
+        }
+        return table;
+    }
+
+    constexpr std::array<FenSymbol, 256> FenSymbols = make_fen_symbols();
+
+    // Indexed by Piece.
+    constexpr std::array<int, 13> SeeValues = {
+        0, 100, 320, 330, 500, 900, 20000, 100, 320, 330, 500, 900, 20000};
+
+    constexpr int see_value(Piece piece)
+    {
+        return SeeValues[static_cast<std::size_t>(piece)];
+    }
+
+    // Hash of everything but piece placement.
+    std::uint64_t state_key(const BoardState& state)
+    {
+        std::uint64_t key = ZobristKeys.castling[state.castlingRights & 0x0F];
+
+        if (state.enPassantSquare != -1)
+        {
+            key ^= ZobristKeys.enPassant[file_of(state.enPassantSquare)];
+        }
+
+        if (state.sideToMove == Color::Black)
+        {
+            key ^= ZobristKeys.sideToMove;
+        }
+
+        return key;
+    }
+
+    bool at_field_end(std::string_view fen, std::size_t pos)
+    {
+        return pos >= fen.size() || fen[pos] == ' ';
+    }
+
+    // Skips the spaces before the next FEN field; false when none is left.
+    bool next_field(std::string_view fen, std::size_t& pos)
+    {
+        while (pos < fen.size() && fen[pos] == ' ')
+        {
+            ++pos;
+        }
+        return pos < fen.size();
+    }
+
+    char char_from_piece(Piece piece)
+    {
+        switch (piece)
+        {
+        case Piece::WhitePawn:   return 'P';
+        case Piece::WhiteKnight: return 'N';
+        case Piece::WhiteBishop: return 'B';
+        case Piece::WhiteRook:   return 'R';
+        case Piece::WhiteQueen:  return 'Q';
+        case Piece::WhiteKing:   return 'K';
+        case Piece::BlackPawn:   return 'p';
+        case Piece::BlackKnight: return 'n';
+        case Piece::BlackBishop: return 'b';
+        case Piece::BlackRook:   return 'r';
+        case Piece::BlackQueen:  return 'q';
+        case Piece::BlackKing:   return 'k';
+        case Piece::None:
+        default:
+            return ' ';
+        }
+    }
+
+    bool is_pawn(Piece piece)
+    {
+        return piece == Piece::WhitePawn || piece == Piece::BlackPawn;
+    }
+
+    // Where a parsed FEN's fields start, for pointing at a rule it breaks.
+    struct FenOffsets
+    {
+        std::size_t placementEnd{0};
+        std::size_t castling{0};
+        std::size_t enPassant{0};
+    };
+
+    // Rules that span fields: one king a side, castling rights backed by
+    // king and rook on their home squares, and an en passant square just
+    // behind an enemy pawn that can have made the double step. Returns
+    // nullptr when the position passes, otherwise the message, with
+    // `offset` set to the field at fault.
+    const char* check_consistency(const std::array<Piece, 64>& squares,
+                                  const std::array<Bitboard, 13>& pieceBitboards,
+                                  const BoardState& state,
+                                  const FenOffsets& offsets,
+                                  std::size_t& offset)
+    {
+        const auto at = [&squares](int file, int rank)
+        {
+            return squares[static_cast<std::size_t>(make_square(file, rank))];
+        };
+
+        if (popcount(pieceBitboards[static_cast<std::size_t>(Piece::WhiteKing)]) != 1 ||
+            popcount(pieceBitboards[static_cast<std::size_t>(Piece::BlackKing)]) != 1)
+        {
+            offset = offsets.placementEnd;
+            return "each side needs exactly one king";
+        }
+
+        const std::uint8_t rights = state.castlingRights;
+        if (((rights & (CastleWhiteKing | CastleWhiteQueen)) != 0 && at(4, 0) != Piece::WhiteKing) ||
+            ((rights & CastleWhiteKing) != 0 && at(7, 0) != Piece::WhiteRook) ||
+            ((rights & CastleWhiteQueen) != 0 && at(0, 0) != Piece::WhiteRook) ||
+            ((rights & (CastleBlackKing | CastleBlackQueen)) != 0 && at(4, 7) != Piece::BlackKing) ||
+            ((rights & CastleBlackKing) != 0 && at(7, 7) != Piece::BlackRook) ||
+            ((rights & CastleBlackQueen) != 0 && at(0, 7) != Piece::BlackRook))
+        {
+            offset = offsets.castling;
+            return "castling right without its king and rook on their home squares";
+        }
+
+        if (state.enPassantSquare != -1)
+        {
+            // White to move: Black just played a pawn from rank 7 to 5 over
+            // a square on rank 6. Mirrored for Black to move.
+            const bool whiteToMove = state.sideToMove == Color::White;
+            const int file = file_of(state.enPassantSquare);
+            if (rank_of(state.enPassantSquare) != (whiteToMove ? 5 : 2))
+            {
+                offset = offsets.enPassant;
+                return "en passant square must be on rank 6 with White to move, rank 3 with Black";
+            }
+            if (at(file, whiteToMove ? 4 : 3) != (whiteToMove ? Piece::BlackPawn : Piece::WhitePawn))
+            {
+                offset = offsets.enPassant;
+                return "en passant square without the pawn that just moved past it";
+            }
+        }
+        return nullptr;
+    }
+}
+
+Position::Position()
+{
+    load_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+}
+
+bool Position::load_fen(std::string_view fen, FenError* error)
+{
+    std::array<Piece, 64> squares{};
+    BoardState state{};
+    std::size_t pos = 0;
+
+    const auto fail =
+        [error](std::size_t offset, const char* message)
+        {
+            if (error != nullptr)
+            {
+                error->offset = offset;
+                error->message = message;
+            }
+            return false;
+        };
+
+    if (!next_field(fen, pos))
+    {
+        return fail(pos, "missing piece placement");
+    }
+
+    // Bitboards are filled in as the pieces are read; runs of empty
+    // squares land in the unused Piece::None entry, cleared afterwards.
+    std::array<Bitboard, 13> pieceBitboards{};
+    std::uint64_t pieceKey = 0;
+    int rank = 7;
+    int file = 0;
+    for (; !at_field_end(fen, pos); ++pos)
+    {
+        const FenSymbol symbol = FenSymbols[static_cast<unsigned char>(fen[pos])];
+        if (symbol.advance == 0)
+        {
+            if (fen[pos] != '/')
+            {
+                return fail(pos, "invalid piece character");
+            }
+            if (file != 8 || rank == 0)
+            {
+                return fail(pos, "rank does not describe 8 files");
+            }
+            --rank;
+            file = 0;
+            continue;
+        }
+
+        if (file + symbol.advance > 8)
+        {
+            return fail(pos, "rank describes more than 8 files");
+        }
+
+        // Digits store Piece::None, whose Zobrist row is zero, so pieces and
+        // empty runs share one path.
+        const int square = make_square(file, rank);
+        squares[static_cast<std::size_t>(square)] = symbol.piece;
+        pieceKey ^= ZobristKeys.pieces[static_cast<std::size_t>(symbol.piece)][square];
+        pieceBitboards[static_cast<std::size_t>(symbol.piece)] |= square_bb(square);
+        file += symbol.advance;
+    }
+    if (rank != 0 || file != 8)
+    {
+        return fail(pos, "placement does not describe 8 ranks");
+    }
+    pieceBitboards[static_cast<std::size_t>(Piece::None)] = 0;
+    FenOffsets offsets;
+    offsets.placementEnd = pos;
+
+    if (!next_field(fen, pos))
+    {
+        return fail(pos, "missing side to move");
+    }
+    if (fen[pos] == 'w' || fen[pos] == 'b')
+    {
+        state.sideToMove = (fen[pos] == 'b') ? Color::Black : Color::White;
+        ++pos;
+    }
+    if (!at_field_end(fen, pos) || (fen[pos - 1] != 'w' && fen[pos - 1] != 'b'))
+    {
+        return fail(pos, "side to move must be 'w' or 'b'");
+    }
+
+    if (!next_field(fen, pos))
+    {
+        return fail(pos, "missing castling rights");
+    }
+    offsets.castling = pos;
+    if (fen[pos] == '-')
+    {
+        ++pos;
+    }
+    else
+    {
+        for (; !at_field_end(fen, pos); ++pos)
+        {
+            switch (fen[pos])
+            {
+            case 'K': state.castlingRights |= CastleWhiteKing; break;
+            case 'Q': state.castlingRights |= CastleWhiteQueen; break;
+            case 'k': state.castlingRights |= CastleBlackKing; break;
+            case 'q': state.castlingRights |= CastleBlackQueen; break;
+            default: return fail(pos, "castling rights must be '-' or letters from KQkq");
+            }
+        }
+    }
+    if (!at_field_end(fen, pos))
+    {
+        return fail(pos, "castling rights must be '-' or letters from KQkq");
+    }
+
+    if (!next_field(fen, pos))
+    {
+        return fail(pos, "missing en passant square");
+    }
+    offsets.enPassant = pos;
+    state.enPassantSquare = -1;
+    if (fen[pos] == '-')
+    {
+        ++pos;
+    }
+    else if (pos + 1 < fen.size() &&
+             fen[pos] >= 'a' && fen[pos] <= 'h' &&
+             (fen[pos + 1] == '3' || fen[pos + 1] == '6'))
+    {
+        state.enPassantSquare = make_square(fen[pos] - 'a', fen[pos + 1] - '1');
+        pos += 2;
+    }
+    if (!at_field_end(fen, pos))
+    {
+        return fail(pos, "en passant square must be '-' or a square on rank 3 or 6");
+    }
+
+    int* const clocks[2] = {&state.halfmoveClock, &state.fullmoveNumber};
+    for (int* clock : clocks)
+    {
+        if (!next_field(fen, pos))
+        {
+            break;
+        }
+        const char* first = fen.data() + pos;
+        const char* last = fen.data() + fen.size();
+        const auto [end, status] = std::from_chars(first, last, *clock);
+        pos += static_cast<std::size_t>(end - first);
+        if (status != std::errc{} || *clock < 0 || !at_field_end(fen, pos))
+        {
+            return fail(pos, "move counters must be non-negative numbers");
+        }
+    }
+
+    std::size_t offset = 0;
+    if (const char* problem = check_consistency(squares, pieceBitboards, state, offsets, offset))
+    {
+        return fail(offset, problem);
+    }
+
+    // The same material key put_piece() builds one piece at a time.
+    std::uint64_t materialKey = 0;
+    Bitboard colors[2] = {0, 0};
+    for (std::size_t piece = 1; piece < pieceBitboards.size(); ++piece)
+    {
+        const int count = popcount(pieceBitboards[piece]);
+        for (int i = 0; i < count; ++i)
+        {
+            materialKey ^= ZobristKeys.material[piece][i];
+        }
+        colors[piece <= static_cast<std::size_t>(Piece::WhiteKing) ? 0 : 1] |= pieceBitboards[piece];
+    }
+
+    squares_ = squares;
+    pieceBitboards_ = pieceBitboards;
+    colorBitboards_ = {colors[0], colors[1]};
+    materialKey_ = materialKey;
+    state_ = state;
+    zobristKey_ = pieceKey ^ state_key(state);
+    return true;
+}
+
+std::string Position::to_fen() const
+{
+    char buffer[FenBufferSize];
+    const std::size_t length = write_fen(buffer, sizeof(buffer));
+    return std::string(buffer, length);
+}
+
+std::size_t Position::write_fen(char* buffer, std::size_t capacity) const noexcept
+{
+    if (capacity < FenBufferSize)
+    {
+        return 0;
+    }
+
+    char* out = buffer;
+
+    for (int rank = 7; rank >= 0; --rank)
+    {
+        char emptyCount = 0;
+        for (int file = 0; file < 8; ++file)
+        {
+            const Piece piece = squares_[static_cast<std::size_t>(make_square(file, rank))];
+            if (piece == Piece::None)
+            {
+                ++emptyCount;
+            }
+            else
+            {
+                if (emptyCount > 0)
+                {
+                    *out++ = static_cast<char>('0' + emptyCount);
+                    emptyCount = 0;
+                }
+                *out++ = char_from_piece(piece);
+            }
+        }
+        if (emptyCount > 0)
+        {
+            *out++ = static_cast<char>('0' + emptyCount);
+        }
+        if (rank > 0)
+        {
+            *out++ = '/';
+        }
+    }
+
+    *out++ = ' ';
+    *out++ = (state_.sideToMove == Color::White) ? 'w' : 'b';
+    *out++ = ' ';
+
+    if (state_.castlingRights == 0)
+    {
+        *out++ = '-';
+    }
+    else
+    {
+        if (state_.castlingRights & CastleWhiteKing) *out++ = 'K';
+        if (state_.castlingRights & CastleWhiteQueen) *out++ = 'Q';
+        if (state_.castlingRights & CastleBlackKing) *out++ = 'k';
+        if (state_.castlingRights & CastleBlackQueen) *out++ = 'q';
+    }
+
+    *out++ = ' ';
+    if (state_.enPassantSquare == -1)
+    {
+        *out++ = '-';
+    }
+    else
+    {
+        *out++ = static_cast<char>('a' + file_of(state_.enPassantSquare));
+        *out++ = static_cast<char>('1' + rank_of(state_.enPassantSquare));
+    }
+
+    char* const end = buffer + capacity - 1;
+    *out++ = ' ';
+    out = std::to_chars(out, end, state_.halfmoveClock).ptr;
+    *out++ = ' ';
+    out = std::to_chars(out, end, state_.fullmoveNumber).ptr;
+    *out = '\0';
+
+    return static_cast<std::size_t>(out - buffer);
+}
+
+std::vector<Move> Position::generate_legal_moves() const
+{
+    std::vector<Move> legalMoves;
+    const std::vector<Move> pseudoMoves = generate_pseudo_legal_moves();
+
+    legalMoves.reserve(pseudoMoves.size());
+
+    for (const Move& move : pseudoMoves)
+    {
+        Position copy = *this;
+        const Color movingSide = copy.side_to_move();
+        copy.make_move(move);
+        if (!copy.is_in_check(movingSide))
+        {
+            legalMoves.push_back(move);
+        }
+    }
+
+    return legalMoves;
+}
+
+bool Position::unpack_move(std::uint16_t packed, Move& out) const
+{
+    const int from = packed & 63;
+    const int to = (packed >> 6) & 63;
+    const int promotionCode = packed >> 12;
+    const Color us = state_.sideToMove;
+    const Piece piece = squares_[static_cast<std::size_t>(from)];
+    const Piece target = squares_[static_cast<std::size_t>(to)];
+
+    if (from == to || promotionCode > 4 || is_empty_piece(piece) ||
+        is_white_piece(piece) != (us == Color::White) ||
+        (!is_empty_piece(target) && is_white_piece(target) == (us == Color::White)))
+    {
+        return false;
+    }
+
+    const Piece pawn = colored_piece(Piece::WhitePawn, us);
+    const std::uint8_t captureFlag = is_empty_piece(target) ? 0 : MoveFlagCapture;
+    const Bitboard toBit = square_bb(to);
+
+    if (piece != pawn)
+    {
+        if (promotionCode != 0)
+        {
+            return false;
+        }
+
+        const Piece whitePiece = static_cast<Piece>((static_cast<int>(piece) - 1) % 6 + 1);
+        bool reachable = false;
+        switch (whitePiece)
+        {
+        case Piece::WhiteKnight:
+            reachable = (KnightAttacks[static_cast<std::size_t>(from)] & toBit) != 0;
+            break;
+        case Piece::WhiteBishop:
+        case Piece::WhiteRook:
+        case Piece::WhiteQueen:
+        {
+            const bool straight = file_of(from) == file_of(to) || rank_of(from) == rank_of(to);
+            const bool aligned = (LineMasks[static_cast<std::size_t>(from)][static_cast<std::size_t>(to)] & toBit) != 0;
+            reachable = aligned &&
+                        (whitePiece == Piece::WhiteQueen || straight == (whitePiece == Piece::WhiteRook));
+            Bitboard between = BetweenMasks[static_cast<std::size_t>(from)][static_cast<std::size_t>(to)];
+            while (reachable && between != 0)
+            {
+                reachable = is_empty_piece(squares_[static_cast<std::size_t>(pop_lsb(between))]);
+            }
+            break;
+        }
+        case Piece::WhiteKing:
+        {
+            if ((KingAttacks[static_cast<std::size_t>(from)] & toBit) != 0)
+            {
+                reachable = true;
+                break;
+            }
+
+            // Castling, only as the generator would offer it.
+            const int homeRank = (us == Color::White) ? 0 : 7;
+            if (to != make_square(6, homeRank) && to != make_square(2, homeRank))
+            {
+                return false;
+            }
+            const bool kingSide = file_of(to) == 6;
+            return (us == Color::White) ? castling_move_for<Color::White>(from, kingSide, out)
+                                        : castling_move_for<Color::Black>(from, kingSide, out);
+        }
+        default:
+            return false;
+        }
+
+        if (!reachable)
+        {
+            return false;
+        }
+        out = Move(from, to, piece, target, Piece::None, captureFlag);
+        return true;
+    }
+
+    const int forward = (us == Color::White) ? 8 : -8;
+    const int startRank = (us == Color::White) ? 1 : 6;
+    const int promotionRank = (us == Color::White) ? 6 : 1;
+    const bool promotes = rank_of(from) == promotionRank;
+    if (promotes != (promotionCode != 0))
+    {
+        return false;
+    }
+    const Piece promotion = promotes
+                                ? colored_piece(static_cast<Piece>(static_cast<int>(Piece::WhiteKnight) +
+                                                                   promotionCode - 1),
+                                                us)
+                                : Piece::None;
+    const std::uint8_t promotionFlag = promotes ? MoveFlagPromotion : 0;
+
+    if (to == from + forward && is_empty_piece(target))
+    {
+        out = Move(from, to, piece, Piece::None, promotion, promotionFlag);
+        return true;
+    }
+    if (to == from + 2 * forward && rank_of(from) == startRank && is_empty_piece(target) &&
+        is_empty_piece(squares_[static_cast<std::size_t>(from + forward)]))
+    {
+        out = Move(from, to, piece, Piece::None, Piece::None,
+                   static_cast<std::uint8_t>(MoveFlagDoublePawnPush));
+        return true;
+    }
+    if ((PawnAttacks[static_cast<std::size_t>(us)][static_cast<std::size_t>(from)] & toBit) != 0)
+    {
+        if (!is_empty_piece(target))
+        {
+            out = Move(from, to, piece, target, promotion,
+                       static_cast<std::uint8_t>(MoveFlagCapture | promotionFlag));
+            return true;
+        }
+        if (to == state_.enPassantSquare)
+        {
+            out = Move(from, to, piece, colored_piece(Piece::WhitePawn, opposite_color(us)),
+                       Piece::None, static_cast<std::uint8_t>(MoveFlagEnPassant | MoveFlagCapture));
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Position::is_pseudo_legal(const Move& move) const
+{
+    if (move.from < 0 || move.from >= 64 || move.to < 0 || move.to >= 64)
+    {
+        return false;
+    }
+
+    Move expected;
+    return unpack_move(pack_move(move), expected) &&
+           expected.from == move.from &&
+           expected.to == move.to &&
+           expected.movingPiece == move.movingPiece &&
+           expected.capturedPiece == move.capturedPiece &&
+           expected.promotionPiece == move.promotionPiece &&
+           expected.flags == move.flags;
+}
+
+bool Position::is_legal(const Move& move) const
+{
+    Position copy = *this;
+    copy.make_move(move);
+    return !copy.is_in_check(state_.sideToMove);
+}
+
+void Position::make_move(const Move& move)
+{
+    const Color movingSide = state_.sideToMove;
+
+    if (movingSide == Color::Black)
+    {
+        ++state_.fullmoveNumber;
+    }
+
+    if (is_pawn(move.movingPiece) || move.capturedPiece != Piece::None)
+    {
+        state_.halfmoveClock = 0;
+    }
+    else
+    {
+        ++state_.halfmoveClock;
+    }
+
+    state_.enPassantSquare = -1;
+
+    const int from = move.from;
+    const int to = move.to;
+
+    Piece movingPiece = move.movingPiece;
+
+    if (move.flags & MoveFlagEnPassant)
+    {
+        if (movingSide == Color::White)
+        {
+            const int captureSquare = to - 8;
+            if (captureSquare >= 0 && captureSquare < 64)
+            {
+                remove_piece(captureSquare);
+            }
+        }
+        else
+        {
+            const int captureSquare = to + 8;
+            if (captureSquare >= 0 && captureSquare < 64)
+            {
+                remove_piece(captureSquare);
+            }
+        }
+    }
+
+    if (move.flags & MoveFlagCastleKingSide)
+    {
+        if (movingSide == Color::White)
+        {
+            const int rookFrom = make_square(7, 0);
+            const int rookTo = make_square(5, 0);
+            put_piece(rookTo, remove_piece(rookFrom));
+        }
+        else
+        {
+            const int rookFrom = make_square(7, 7);
+            const int rookTo = make_square(5, 7);
+            put_piece(rookTo, remove_piece(rookFrom));
+        }
+    }
+    else if (move.flags & MoveFlagCastleQueenSide)
+    {
+        if (movingSide == Color::White)
+        {
+            const int rookFrom = make_square(0, 0);
+            const int rookTo = make_square(3, 0);
+            put_piece(rookTo, remove_piece(rookFrom));
+        }
+        else
+        {
+            const int rookFrom = make_square(0, 7);
+            const int rookTo = make_square(3, 7);
+            put_piece(rookTo, remove_piece(rookFrom));
+        }
+    }
+
+    remove_piece(from);
+    Piece placedPiece = movingPiece;
+    if (move.flags & MoveFlagPromotion)
+    {
+        placedPiece = move.promotionPiece;
+    }
+    remove_piece(to);
+    put_piece(to, placedPiece);
+
+    const int fromFile = file_of(from);
+    const int fromRank = rank_of(from);
+
+    if (movingPiece == Piece::WhiteKing)
+    {
+        state_.castlingRights &= static_cast<std::uint8_t>(~(CastleWhiteKing | CastleWhiteQueen));
+    }
+    else if (movingPiece == Piece::BlackKing)
+    {
+        state_.castlingRights &= static_cast<std::uint8_t>(~(CastleBlackKing | CastleBlackQueen));
+    }
+
+    if (movingPiece == Piece::WhiteRook)
+    {
+        if (fromFile == 0 && fromRank == 0)
+        {
+            state_.castlingRights &= static_cast<std::uint8_t>(~CastleWhiteQueen);
+        }
+        else if (fromFile == 7 && fromRank == 0)
+        {
+            state_.castlingRights &= static_cast<std::uint8_t>(~CastleWhiteKing);
+        }
+    }
+    else if (movingPiece == Piece::BlackRook)
+    {
+        if (fromFile == 0 && fromRank == 7)
+        {
+            state_.castlingRights &= static_cast<std::uint8_t>(~CastleBlackQueen);
+        }
+        else if (fromFile == 7 && fromRank == 7)
+        {
+            state_.castlingRights &= static_cast<std::uint8_t>(~CastleBlackKing);
+        }
+    }
+
+    if (move.capturedPiece == Piece::WhiteRook)
+    {
+        const int toFile = file_of(to);
+        const int toRank = rank_of(to);
+        if (toFile == 0 && toRank == 0)
+        {
+            state_.castlingRights &= static_cast<std::uint8_t>(~CastleWhiteQueen);
+        }
+        else if (toFile == 7 && toRank == 0)
+        {
+            state_.castlingRights &= static_cast<std::uint8_t>(~CastleWhiteKing);
+        }
+    }
+    else if (move.capturedPiece == Piece::BlackRook)
+    {
+        const int toFile = file_of(to);
+        const int toRank = rank_of(to);
+        if (toFile == 0 && toRank == 7)
+        {
+            state_.castlingRights &= static_cast<std::uint8_t>(~CastleBlackQueen);
+        }
+        else if (toFile == 7 && toRank == 7)
+        {
+            state_.castlingRights &= static_cast<std::uint8_t>(~CastleBlackKing);
+        }
+    }
+
+    if (is_pawn(movingPiece) && (move.flags & MoveFlagDoublePawnPush))
+    {
+        if (movingSide == Color::White)
+        {
+            state_.enPassantSquare = from + 8;
+        }
+        else
+        {
+            state_.enPassantSquare = from - 8;
+        }
+    }
+
+    state_.sideToMove = opposite_color(state_.sideToMove);
+
+    zobristKey_ = compute_zobrist();
+}
+
+void Position::make_null_move()
+{
+    if (state_.sideToMove == Color::Black)
+    {
+        ++state_.fullmoveNumber;
+    }
+
+    ++state_.halfmoveClock;
+    state_.enPassantSquare = -1;
+    state_.sideToMove = opposite_color(state_.sideToMove);
+
+    zobristKey_ = compute_zobrist();
+}
+
+Color Position::side_to_move() const noexcept
+{
+    return state_.sideToMove;
+}
+
+int Position::fullmove_number() const noexcept
+{
+    return state_.fullmoveNumber;
+}
+
+int Position::halfmove_clock() const noexcept
+{
+    return state_.halfmoveClock;
+}
+
+Piece Position::piece_at(int square) const noexcept
+{
+    if (square < 0 || square >= 64)
+    {
+        return Piece::None;
+    }
+    return squares_[static_cast<std::size_t>(square)];
+}
+
+void Position::set_piece_at(int square, Piece piece)
+{
+    if (square < 0 || square >= 64)
+    {
+        return;
+    }
+    remove_piece(square);
+    put_piece(square, piece);
+}
+
+std::uint64_t Position::zobrist_key() const noexcept
+{
+    return zobristKey_;
+}
+
+std::uint64_t Position::material_key() const noexcept
+{
+    return materialKey_;
+}
+
+bool Position::is_in_check(Color side) const
+{
+    const int kingSquare = king_square(side);
+    if (kingSquare == -1)
+    {
+        return false;
+    }
+
+    return is_square_attacked(kingSquare, opposite_color(side));
+}
+
+CheckInfo Position::check_info() const
+{
+    CheckInfo info;
+    const Color us = state_.sideToMove;
+    const Color them = opposite_color(us);
+    info.kingSquare = king_square(them);
+    if (info.kingSquare == -1)
+    {
+        return info;
+    }
+
+    const std::size_t king = static_cast<std::size_t>(info.kingSquare);
+    const Piece bishop = colored_piece(Piece::WhiteBishop, us);
+    const Piece rook = colored_piece(Piece::WhiteRook, us);
+    const Piece queen = colored_piece(Piece::WhiteQueen, us);
+
+    // Our pawns check from where their pawn on the king square would capture.
+    info.checkSquares[0] = PawnAttacks[static_cast<std::size_t>(them)][king];
+    info.checkSquares[1] = KnightAttacks[king];
+
+    for (int direction = 0; direction < DirectionCount; ++direction)
+    {
+        const bool straight = direction < FirstBishopDirection;
+        const Piece slider = straight ? rook : bishop;
+        const Ray& ray = SquareRays[static_cast<std::size_t>(direction)][king];
+
+        // Up to and including the first piece; one of ours there may still
+        // uncover a slider behind it.
+        std::uint8_t step = 0;
+        for (; step < ray.length; ++step)
+        {
+            info.checkSquares[straight ? 3 : 2] |= square_bb(ray.squares[step]);
+            if (!is_empty_piece(squares_[ray.squares[step]]))
+            {
+                break;
+            }
+        }
+        if (step >= ray.length ||
+            is_white_piece(squares_[ray.squares[step]]) != (us == Color::White))
+        {
+            continue;
+        }
+
+        const int blocker = ray.squares[step];
+        for (++step; step < ray.length; ++step)
+        {
+            const Piece piece = squares_[ray.squares[step]];
+            if (is_empty_piece(piece))
+            {
+                continue;
+            }
+            if (piece == slider || piece == queen)
+            {
+                info.discoveredBlockers |= square_bb(blocker);
+            }
+            break;
+        }
+    }
+    info.checkSquares[4] = info.checkSquares[2] | info.checkSquares[3];
+
+    return info;
+}
+
+bool Position::gives_check(const Move& move, const CheckInfo& info) const
+{
+    if (info.kingSquare == -1)
+    {
+        return false;
+    }
+
+    if ((move.flags & (MoveFlagPromotion | MoveFlagEnPassant |
+                       MoveFlagCastleKingSide | MoveFlagCastleQueenSide)) != 0)
+    {
+        Position copy = *this;
+        copy.make_move(move);
+        return copy.is_in_check(copy.side_to_move());
+    }
+
+    const std::size_t type = static_cast<std::size_t>((static_cast<int>(move.movingPiece) - 1) % 6);
+    if (type < info.checkSquares.size() && (info.checkSquares[type] & square_bb(move.to)) != 0)
+    {
+        return true;
+    }
+
+    // A blocker stepping along its own line keeps the line shut.
+    return (info.discoveredBlockers & square_bb(move.from)) != 0 &&
+           (LineMasks[static_cast<std::size_t>(move.from)][static_cast<std::size_t>(info.kingSquare)] &
+            square_bb(move.to)) == 0;
+}
+
+bool Position::gives_check(const Move& move) const
+{
+    return gives_check(move, check_info());
+}
+
+std::uint64_t Position::compute_zobrist() const
+{
+    std::uint64_t key = state_key(state_);
+
+    for (int square = 0; square < 64; ++square)
+    {
+        const int pieceIndex = static_cast<int>(squares_[static_cast<std::size_t>(square)]);
+        key ^= ZobristKeys.pieces[pieceIndex][square];
+    }
+
+    return key;
+}
+
+std::vector<Move> Position::generate_pseudo_legal_moves() const
+{
+    return state_.sideToMove == Color::White
+               ? generate_pseudo_legal_moves_for<Color::White>()
+               : generate_pseudo_legal_moves_for<Color::Black>();
+}
+
+template <Color Us>
+std::vector<Move> Position::generate_pseudo_legal_moves_for() const
+{
+    constexpr Color Them = opposite_color(Us);
+    constexpr Piece Pawn = colored_piece(Piece::WhitePawn, Us);
+    constexpr Piece Knight = colored_piece(Piece::WhiteKnight, Us);
+    constexpr Piece Bishop = colored_piece(Piece::WhiteBishop, Us);
+    constexpr Piece Rook = colored_piece(Piece::WhiteRook, Us);
+    constexpr Piece Queen = colored_piece(Piece::WhiteQueen, Us);
+    constexpr Piece King = colored_piece(Piece::WhiteKing, Us);
+    constexpr Piece EnemyPawn = colored_piece(Piece::WhitePawn, Them);
+    constexpr int Forward = (Us == Color::White) ? 8 : -8;
+    constexpr int StartRank = (Us == Color::White) ? 1 : 6;
+    constexpr int PromotionRank = (Us == Color::White) ? 6 : 1;
+    constexpr Piece Promotions[4] = {Queen, Rook, Bishop, Knight};
+    const auto& pawnAttacks = PawnAttacks[static_cast<std::size_t>(Us)];
+
+    std::vector<Move> moves;
+    moves.reserve(64);
+
+    const auto add_target =
+        [&](int from, int targetSquare, Piece piece)
+        {
+            const Piece targetPiece = squares_[static_cast<std::size_t>(targetSquare)];
+            if (is_empty_piece(targetPiece))
+            {
+                moves.emplace_back(from, targetSquare, piece);
+                return true;
+            }
+            if (is_piece_of<Them>(targetPiece))
+            {
+                moves.emplace_back(from,
+                                   targetSquare,
+                                   piece,
+                                   targetPiece,
+                                   Piece::None,
+                                   static_cast<std::uint8_t>(MoveFlagCapture));
+            }
+            return false;
+        };
+
+    const auto add_slides =
+        [&](int from, Piece piece, int firstDirection, int lastDirection)
+        {
+            for (int direction = firstDirection; direction < lastDirection; ++direction)
+            {
+                const Ray& ray = SquareRays[static_cast<std::size_t>(direction)][static_cast<std::size_t>(from)];
+                for (std::uint8_t step = 0; step < ray.length; ++step)
+                {
+                    if (!add_target(from, ray.squares[step], piece))
+                    {
+                        break;
+                    }
+                }
+            }
+        };
+
+    Bitboard own = colorBitboards_[static_cast<std::size_t>(Us)];
+    while (own != 0)
+    {
+        const int square = pop_lsb(own);
+        const Piece piece = squares_[static_cast<std::size_t>(square)];
+
+        if (piece == Pawn)
+        {
+            const int rank = rank_of(square);
+            const int forwardSquare = square + Forward;
+            if (forwardSquare >= 0 && forwardSquare < 64 &&
+                squares_[static_cast<std::size_t>(forwardSquare)] == Piece::None)
+            {
+                if (rank == PromotionRank)
+                {
+                    for (Piece promoPiece : Promotions)
+                    {
+                        Move move(square,
+                                  forwardSquare,
+                                  piece,
+                                  Piece::None,
+                                  promoPiece,
+                                  static_cast<std::uint8_t>(MoveFlagPromotion));
+                        moves.push_back(move);
+                    }
+                }
+                else
+                {
+                    Move move(square, forwardSquare, piece);
+                    moves.push_back(move);
+
+                    if (rank == StartRank)
+                    {
+                        const int doubleSquare = forwardSquare + Forward;
+                        if (squares_[static_cast<std::size_t>(doubleSquare)] == Piece::None)
+                        {
+                            Move doubleMove(square,
+                                            doubleSquare,
+                                            piece,
+                                            Piece::None,
+                                            Piece::None,
+                                            static_cast<std::uint8_t>(MoveFlagDoublePawnPush));
+                            moves.push_back(doubleMove);
+                        }
+                    }
+                }
+            }
+
+            Bitboard targets = pawnAttacks[static_cast<std::size_t>(square)];
+            while (targets != 0)
+            {
+                const int targetSquare = pop_lsb(targets);
+                const Piece targetPiece = squares_[static_cast<std::size_t>(targetSquare)];
+
+                if (is_piece_of<Them>(targetPiece))
+                {
+                    if (rank == PromotionRank)
+                    {
+                        for (Piece promoPiece : Promotions)
+                        {
+                            Move move(square,
+                                      targetSquare,
+                                      piece,
+                                      targetPiece,
+                                      promoPiece,
+                                      static_cast<std::uint8_t>(MoveFlagCapture | MoveFlagPromotion));
+                            moves.push_back(move);
+                        }
+                    }
+                    else
+                    {
+                        Move move(square,
+                                  targetSquare,
+                                  piece,
+                                  targetPiece,
+                                  Piece::None,
+                                  static_cast<std::uint8_t>(MoveFlagCapture));
+                        moves.push_back(move);
+                    }
+                }
+
+                if (state_.enPassantSquare == targetSquare)
+                {
+                    Move move(square,
+                              targetSquare,
+                              piece,
+                              EnemyPawn,
+                              Piece::None,
+                              static_cast<std::uint8_t>(MoveFlagEnPassant | MoveFlagCapture));
+                    moves.push_back(move);
+                }
+            }
+        }
+        else if (piece == Knight)
+        {
+            Bitboard targets = KnightAttacks[static_cast<std::size_t>(square)];
+            while (targets != 0)
+            {
+                add_target(square, pop_lsb(targets), piece);
+            }
+        }
+        else if (piece == Bishop)
+        {
+            add_slides(square, piece, FirstBishopDirection, DirectionCount);
+        }
+        else if (piece == Rook)
+        {
+            add_slides(square, piece, FirstRookDirection, FirstBishopDirection);
+        }
+        else if (piece == Queen)
+        {
+            add_slides(square, piece, FirstRookDirection, DirectionCount);
+        }
+        else if (piece == King)
+        {
+            Bitboard targets = KingAttacks[static_cast<std::size_t>(square)];
+            while (targets != 0)
+            {
+                add_target(square, pop_lsb(targets), piece);
+            }
+
+            Move castle;
+            for (const bool kingSide : {true, false})
+            {
+                if (castling_move_for<Us>(square, kingSide, castle))
+                {
+                    moves.push_back(castle);
+                }
+            }
+        }
+    }
+
+    return moves;
+}
+
+template <Color Us>
+bool Position::castling_move_for(int kingSquare, bool kingSide, Move& out) const
+{
+    constexpr Color Them = opposite_color(Us);
+    constexpr Piece King = colored_piece(Piece::WhiteKing, Us);
+    constexpr int HomeRank = (Us == Color::White) ? 0 : 7;
+    constexpr std::uint8_t KingSideRight = (Us == Color::White) ? CastleWhiteKing : CastleBlackKing;
+    constexpr std::uint8_t QueenSideRight = (Us == Color::White) ? CastleWhiteQueen : CastleBlackQueen;
+
+    if ((state_.castlingRights & (kingSide ? KingSideRight : QueenSideRight)) == 0)
+    {
+        return false;
+    }
+
+    // The king's path must be empty and safe; queen side also needs b-file empty.
+    const int step = kingSide ? 1 : -1;
+    const int lastEmptyFile = kingSide ? 6 : 1;
+    for (int file = 4 + step; file != lastEmptyFile + step; file += step)
+    {
+        if (piece_at(make_square(file, HomeRank)) != Piece::None)
+        {
+            return false;
+        }
+    }
+    for (int file = 4; file != 4 + 3 * step; file += step)
+    {
+        if (is_square_attacked_by<Them>(make_square(file, HomeRank)))
+        {
+            return false;
+        }
+    }
+
+    out = Move(kingSquare,
+               make_square(4 + 2 * step, HomeRank),
+               King,
+               Piece::None,
+               Piece::None,
+               static_cast<std::uint8_t>(kingSide ? MoveFlagCastleKingSide : MoveFlagCastleQueenSide));
+    return true;
+}
+
+bool Position::is_square_attacked(int square, Color bySide) const
+{
+    return bySide == Color::White ? is_square_attacked_by<Color::White>(square)
+                                  : is_square_attacked_by<Color::Black>(square);
+}
+
+template <Color By>
+bool Position::is_square_attacked_by(int square) const
+{
+    constexpr Piece Pawn = colored_piece(Piece::WhitePawn, By);
+    constexpr Piece Knight = colored_piece(Piece::WhiteKnight, By);
+    constexpr Piece Bishop = colored_piece(Piece::WhiteBishop, By);
+    constexpr Piece Rook = colored_piece(Piece::WhiteRook, By);
+    constexpr Piece Queen = colored_piece(Piece::WhiteQueen, By);
+    constexpr Piece King = colored_piece(Piece::WhiteKing, By);
+    // A pawn of `By` attacks `square` from where a pawn of the other color
+    // standing on `square` would attack.
+    const auto& pawnAttacks = PawnAttacks[static_cast<std::size_t>(opposite_color(By))];
+
+    const auto any_on =
+        [this](Bitboard candidates, Piece attacker)
+        {
+            return (candidates & pieceBitboards_[static_cast<std::size_t>(attacker)]) != 0;
+        };
+
+    if (any_on(pawnAttacks[static_cast<std::size_t>(square)], Pawn) ||
+        any_on(KnightAttacks[static_cast<std::size_t>(square)], Knight) ||
+        any_on(KingAttacks[static_cast<std::size_t>(square)], King))
+    {
+        return true;
+    }
+
+    for (int direction = 0; direction < DirectionCount; ++direction)
+    {
+        const Piece slider = (direction < FirstBishopDirection) ? Rook : Bishop;
+        const Ray& ray = SquareRays[static_cast<std::size_t>(direction)][static_cast<std::size_t>(square)];
+        for (std::uint8_t step = 0; step < ray.length; ++step)
+        {
+            const Piece targetPiece = squares_[ray.squares[step]];
+            if (!is_empty_piece(targetPiece))
+            {
+                if (targetPiece == slider || targetPiece == Queen)
+                {
+                    return true;
+                }
+                break;
+            }
+        }
+    }
+
+    return false;
+}
+
+int Position::least_valuable_attacker(int square, Color by, Bitboard removed) const
+{
+    const Piece pawn = colored_piece(Piece::WhitePawn, by);
+    const Piece knight = colored_piece(Piece::WhiteKnight, by);
+    const Piece bishop = colored_piece(Piece::WhiteBishop, by);
+    const Piece rook = colored_piece(Piece::WhiteRook, by);
+    const Piece queen = colored_piece(Piece::WhiteQueen, by);
+    const Piece king = colored_piece(Piece::WhiteKing, by);
+    const std::size_t target = static_cast<std::size_t>(square);
+
+    const auto find_on =
+        [this, removed](Bitboard candidates, Piece wanted)
+        {
+            candidates &= ~removed;
+            while (candidates != 0)
+            {
+                const int from = pop_lsb(candidates);
+                if (squares_[static_cast<std::size_t>(from)] == wanted)
+                {
+                    return from;
+                }
+            }
+            return -1;
+        };
+
+    if (const int from = find_on(PawnAttacks[static_cast<std::size_t>(opposite_color(by))][target], pawn);
+        from >= 0)
+    {
+        return from;
+    }
+    if (const int from = find_on(KnightAttacks[target], knight); from >= 0)
+    {
+        return from;
+    }
+
+    // First piece along each ray, looking through removed ones: bishops,
+    // rooks, then queens.
+    int sliders[3] = {-1, -1, -1};
+    for (int direction = 0; direction < DirectionCount; ++direction)
+    {
+        const Piece slider = (direction < FirstBishopDirection) ? rook : bishop;
+        const Ray& ray = SquareRays[static_cast<std::size_t>(direction)][target];
+        for (std::uint8_t step = 0; step < ray.length; ++step)
+        {
+            const int from = ray.squares[step];
+            const Piece piece = squares_[static_cast<std::size_t>(from)];
+            if (is_empty_piece(piece) || (removed & square_bb(from)) != 0)
+            {
+                continue;
+            }
+            if (piece == slider)
+            {
+                sliders[slider == bishop ? 0 : 1] = from;
+            }
+            else if (piece == queen)
+            {
+                sliders[2] = from;
+            }
+            break;
+        }
+    }
+    for (const int from : sliders)
+    {
+        if (from >= 0)
+        {
+            return from;
+        }
+    }
+
+    return find_on(KingAttacks[target], king);
+}
+
+int Position::see(const Move& move) const
+{
+    if ((move.flags & (MoveFlagCastleKingSide | MoveFlagCastleQueenSide)) != 0)
+    {
+        return 0;
+    }
+
+    const bool promotion = (move.flags & MoveFlagPromotion) != 0;
+    Bitboard removed = square_bb(move.from);
+    int captured = see_value(squares_[static_cast<std::size_t>(move.to)]);
+    if ((move.flags & MoveFlagEnPassant) != 0)
+    {
+        const int pawnSquare = (move.to & 7) | (move.from & ~7);
+        removed |= square_bb(pawnSquare);
+        captured = see_value(Piece::WhitePawn);
+    }
+
+    // gain[d]: balance for the side making capture d if the exchange were
+    // to stop after it; computed one capture ahead of finding its attacker.
+    std::array<int, 32> gain{};
+    gain[0] = captured +
+              (promotion ? see_value(move.promotionPiece) - see_value(Piece::WhitePawn) : 0);
+    int attackerValue = see_value(promotion ? move.promotionPiece : move.movingPiece);
+    Color side = is_white_piece(move.movingPiece) ? Color::Black : Color::White;
+
+    std::size_t depth = 0;
+    while (depth + 1 < gain.size())
+    {
+        ++depth;
+        gain[depth] = attackerValue - gain[depth - 1];
+
+        const int from = least_valuable_attacker(move.to, side, removed);
+        if (from < 0)
+        {
+            break;
+        }
+        // The king may only take when nothing recaptures.
+        const Piece attacker = squares_[static_cast<std::size_t>(from)];
+        if (attacker == colored_piece(Piece::WhiteKing, side) &&
+            least_valuable_attacker(move.to, opposite_color(side), removed | square_bb(from)) >= 0)
+        {
+            break;
+        }
+
+        attackerValue = see_value(attacker);
+        removed |= square_bb(from);
+        side = opposite_color(side);
+    }
+
+    while (--depth > 0)
+    {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+    }
+    return gain[0];
+}
+
+int Position::king_square(Color side) const noexcept
+{
+    const Bitboard king = pieceBitboards_[static_cast<std::size_t>(colored_piece(Piece::WhiteKing, side))];
+    return king != 0 ? lsb(king) : -1;
+}
+
+Bitboard Position::pieces(Piece piece) const noexcept
+{
+    return pieceBitboards_[static_cast<std::size_t>(piece)];
+}
+
+Bitboard Position::pieces(Color side) const noexcept
+{
+    return colorBitboards_[static_cast<std::size_t>(side)];
+}
+
+int Position::piece_count(Piece piece) const noexcept
+{
+    return popcount(pieceBitboards_[static_cast<std::size_t>(piece)]);
+}
+
+void Position::put_piece(int square, Piece piece)
+{
+    squares_[static_cast<std::size_t>(square)] = piece;
+    if (is_empty_piece(piece))
+    {
+        return;
+    }
+    const Bitboard bit = square_bb(square);
+    materialKey_ ^= ZobristKeys.material[static_cast<std::size_t>(piece)]
+                                        [popcount(pieceBitboards_[static_cast<std::size_t>(piece)])];
+    pieceBitboards_[static_cast<std::size_t>(piece)] |= bit;
+    colorBitboards_[is_white_piece(piece) ? 0 : 1] |= bit;
+}
+
+Piece Position::remove_piece(int square)
+{
+    const Piece piece = squares_[static_cast<std::size_t>(square)];
+    if (is_empty_piece(piece))
+    {
+        return piece;
+    }
+    const Bitboard bit = square_bb(square);
+    pieceBitboards_[static_cast<std::size_t>(piece)] &= ~bit;
+    colorBitboards_[is_white_piece(piece) ? 0 : 1] &= ~bit;
+    materialKey_ ^= ZobristKeys.material[static_cast<std::size_t>(piece)]
+                                        [popcount(pieceBitboards_[static_cast<std::size_t>(piece)])];
+    squares_[static_cast<std::size_t>(square)] = Piece::None;
+    return piece;
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "bitboard.h"
+#include "move.h"
+
+enum class Color : std::uint8_t
+{
+    White,
+    Black
+};
+
+enum class Piece : std::uint8_t
+{
+    None = 0,
+    WhitePawn,
+    WhiteKnight,
+    WhiteBishop,
+    WhiteRook,
+    WhiteQueen,
+    WhiteKing,
+    BlackPawn,
+    BlackKnight,
+    BlackBishop,
+    BlackRook,
+    BlackQueen,
+    BlackKing
+};
+
+inline bool is_white_piece(Piece piece) noexcept
+{
+    return piece >= Piece::WhitePawn && piece <= Piece::WhiteKing;
+}
+
+inline bool is_black_piece(Piece piece) noexcept
+{
+    return piece >= Piece::BlackPawn && piece <= Piece::BlackKing;
+}
+
+inline bool is_empty_piece(Piece piece) noexcept
+{
+    return piece == Piece::None;
+}
+
+constexpr Color opposite_color(Color color) noexcept
+{
+    return color == Color::White ? Color::Black : Color::White;
+}
+
+// Piece of `color` for a given white piece, e.g. (WhiteRook, Black) -> BlackRook.
+constexpr Piece colored_piece(Piece whitePiece, Color color) noexcept
+{
+    return color == Color::White
+               ? whitePiece
+               : static_cast<Piece>(static_cast<int>(whitePiece) + 6);
+}
+
+template <Color C>
+constexpr bool is_piece_of(Piece piece) noexcept
+{
+    if constexpr (C == Color::White)
+    {
+        return piece >= Piece::WhitePawn && piece <= Piece::WhiteKing;
+    }
+    else
+    {
+        return piece >= Piece::BlackPawn && piece <= Piece::BlackKing;
+    }
+}
+
+struct BoardState
+{
+    Color sideToMove{Color::White};
+    std::uint8_t castlingRights{0};
+    int enPassantSquare{-1};
+    int halfmoveClock{0};
+    int fullmoveNumber{1};
+};
+
+// Where and why a FEN string was rejected; `offset` is the index of the
+// offending character in the input.
+struct FenError
+{
+    std::size_t offset{0};
+    const char* message{""};
+};
+
+// What gives_check() needs to know about the opponent's king, computed once
+// per position and shared by all of its moves.
+struct CheckInfo
+{
+    // Opponent's king, or -1 when it has none.
+    int kingSquare{-1};
+    // Squares a piece of the side to move would check the king from,
+    // indexed by piece type (pawn, knight, bishop, rook, queen, king).
+    std::array<Bitboard, 6> checkSquares{};
+    // Pieces of the side to move that alone shield the king from one of
+    // their own sliders; moving one off that line is a discovered check.
+    Bitboard discoveredBlockers{0};
+};
+
+// Buffer size that always fits a FEN written by Position::write_fen,
+// including the terminating NUL.
+inline constexpr std::size_t FenBufferSize = 128;
+
+// Trivially copyable snapshot of a position: piece placement, game state and
+// hash key, with no heap storage. Copying one is a plain memcpy, so callers
+// that only need to test a move can copy-make instead of make/undo.
+class Position
+{
+public:
+    Position();
+
+    // Parses all six FEN fields (the two clocks may be omitted). On failure
+    // the position is left unchanged and `error`, if given, says why.
+    bool load_fen(std::string_view fen, FenError* error = nullptr);
+    [[nodiscard]] std::string to_fen() const;
+    // Writes the NUL-terminated FEN into `buffer` and returns its length, or
+    // returns 0 without writing when `capacity` is below FenBufferSize.
+    std::size_t write_fen(char* buffer, std::size_t capacity) const noexcept;
+
+    [[nodiscard]] std::vector<Move> generate_legal_moves() const;
+
+    // Rebuilds the Move the generator would produce for a pack_move() id,
+    // e.g. a transposition table move. Returns false unless that move is
+    // pseudo-legal here. Constant time; nothing is generated.
+    bool unpack_move(std::uint16_t packed, Move& out) const;
+    // True when `move` is one generate_pseudo_legal_moves() would produce,
+    // e.g. a killer remembered from a sibling position.
+    [[nodiscard]] bool is_pseudo_legal(const Move& move) const;
+    // For a pseudo-legal move: true unless it leaves the mover in check.
+    [[nodiscard]] bool is_legal(const Move& move) const;
+
+    void make_move(const Move& move);
+    void make_null_move();
+
+    [[nodiscard]] Color side_to_move() const noexcept;
+    [[nodiscard]] int fullmove_number() const noexcept;
+    [[nodiscard]] int halfmove_clock() const noexcept;
+    [[nodiscard]] Piece piece_at(int square) const noexcept;
+    void set_piece_at(int square, Piece piece);
+
+    [[nodiscard]] std::uint64_t zobrist_key() const noexcept;
+    // Hash of the piece counts alone; equal for positions with the same
+    // material whatever the placement.
+    [[nodiscard]] std::uint64_t material_key() const noexcept;
+
+    // Kept up to date by every placement change, so these are constant time.
+    [[nodiscard]] Bitboard pieces(Piece piece) const noexcept;
+    [[nodiscard]] Bitboard pieces(Color side) const noexcept;
+    [[nodiscard]] int piece_count(Piece piece) const noexcept;
+    // -1 when `side` has no king, e.g. in a half-edited position.
+    [[nodiscard]] int king_square(Color side) const noexcept;
+
+    [[nodiscard]] bool is_in_check(Color side) const;
+
+    [[nodiscard]] CheckInfo check_info() const;
+    // True when the pseudo-legal `move` checks the opponent, without
+    // making it. Castling, en passant and promotions, which move or remove
+    // a second piece, fall back to copy-make.
+    [[nodiscard]] bool gives_check(const Move& move, const CheckInfo& info) const;
+    [[nodiscard]] bool gives_check(const Move& move) const;
+
+    // Static exchange evaluation: the material, in centipawns, that the
+    // mover nets from `move` followed by the best sequence of recaptures
+    // on its target square, each side using its least valuable attacker.
+    // Pins are ignored.
+    [[nodiscard]] int see(const Move& move) const;
+
+private:
+    std::array<Piece, 64> squares_{};
+    // Same placement by Piece (index 0 unused) and by Color.
+    std::array<Bitboard, 13> pieceBitboards_{};
+    std::array<Bitboard, 2> colorBitboards_{};
+    BoardState state_{};
+    std::uint64_t zobristKey_{0};
+    std::uint64_t materialKey_{0};
+
+    [[nodiscard]] std::uint64_t compute_zobrist() const;
+    [[nodiscard]] std::vector<Move> generate_pseudo_legal_moves() const;
+    [[nodiscard]] bool is_square_attacked(int square, Color bySide) const;
+
+    template <Color Us>
+    [[nodiscard]] std::vector<Move> generate_pseudo_legal_moves_for() const;
+    template <Color By>
+    [[nodiscard]] bool is_square_attacked_by(int square) const;
+    // Castling move for `Us` on one side when rights, empty squares and
+    // an unattacked king path allow it.
+    template <Color Us>
+    bool castling_move_for(int kingSquare, bool kingSide, Move& out) const;
+    // The only writers of squares_, keeping the bitboards and the
+    // material key in step.
+    void put_piece(int square, Piece piece);
+    Piece remove_piece(int square);
+    // Square of the cheapest piece of `by` attacking `square` once the
+    // pieces on `removed` are gone, or -1.
+    [[nodiscard]] int least_valuable_attacker(int square, Color by, std::uint64_t removed) const;
+};
+
+static_assert(std::is_trivially_copyable_v<Position>,
+              "Position must stay memcpy-able for copy-make");
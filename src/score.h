@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+
+// Middlegame and endgame values packed into one 32-bit integer, endgame in
+// the upper half, so adding or subtracting two Scores updates both phases
+// with a single integer operation. Each half must stay within int16_t;
+// evaluation keeps the two together until the final taper.
+class Score
+{
+public:
+    constexpr Score() noexcept = default;
+    constexpr Score(int mg, int eg) noexcept
+        : value_(static_cast<std::int32_t>(static_cast<std::uint32_t>(eg) << 16) + mg)
+    {
+    }
+
+    [[nodiscard]] constexpr int mg() const noexcept
+    {
+        return static_cast<std::int16_t>(static_cast<std::uint16_t>(static_cast<std::uint32_t>(value_)));
+    }
+
+    // Rounds the borrow a negative mg half took from the upper half back in.
+    [[nodiscard]] constexpr int eg() const noexcept
+    {
+        return static_cast<std::int16_t>(
+            static_cast<std::uint16_t>((static_cast<std::uint32_t>(value_) + 0x8000U) >> 16));
+    }
+
+    constexpr Score& operator+=(Score other) noexcept
+    {
+        value_ += other.value_;
+        return *this;
+    }
+
+    constexpr Score& operator-=(Score other) noexcept
+    {
+        value_ -= other.value_;
+        return *this;
+    }
+
+    friend constexpr Score operator+(Score a, Score b) noexcept
+    {
+        return a += b;
+    }
+
+    friend constexpr Score operator-(Score a, Score b) noexcept
+    {
+        return a -= b;
+    }
+
+    friend constexpr Score operator-(Score a) noexcept
+    {
+        return from_raw(-a.value_);
+    }
+
+    friend constexpr Score operator*(Score a, int factor) noexcept
+    {
+        return from_raw(a.value_ * factor);
+    }
+
+    friend constexpr bool operator==(Score a, Score b) noexcept
+    {
+        return a.value_ == b.value_;
+    }
+
+    friend constexpr bool operator!=(Score a, Score b) noexcept
+    {
+        return a.value_ != b.value_;
+    }
+
+private:
+    static constexpr Score from_raw(std::int32_t value) noexcept
+    {
+        Score score;
+        score.value_ = value;
+        return score;
+    }
+
+    std::int32_t value_{0};
+};
+
+static_assert(sizeof(Score) == 4, "Score must stay one packed 32-bit word");
+static_assert(Score(-5, 7).mg() == -5 && Score(-5, 7).eg() == 7, "Score halves must round-trip");
+static_assert((Score(3, -4) - Score(10, 20)).eg() == -24, "Score arithmetic must carry between halves");
@@ -2,14 +2,21 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <utility>
 #include <vector>
 
+#include "attack_tables.h"
 #include "board.h"
 #include "eval.h"
 #include "move.h"
+#include "trace.h"
+#include "transposition_table.h"
 
 namespace
 {
@@ -17,44 +24,53 @@ namespace
     constexpr int MateThreshold = MateValue - 1024;
     constexpr int InfinityScore = std::numeric_limits<int>::max() / 16;
     constexpr int MaxSearchDepth = 64;
-    constexpr std::size_t TTSize = 1ULL << 20;
 
-    enum class NodeType : std::uint8_t
-    {
-        Exact,
-        LowerBound,
-        UpperBound
-    };
+    // ProbCut: at this depth and above, a winning capture that beats beta
+    // by the margin in a search this much shallower cuts the node.
+    constexpr int ProbCutMinDepth = 4;
+    constexpr int ProbCutReduction = 3;
+    constexpr int ProbCutMargin = 150;
+
+    // Cluster mode: how often the root pulls in other processes' entries.
+    constexpr int ExchangeIntervalMs = 20;
+
+    // Lazy SMP iteration skipping: helper i skips a depth when
+    // ((depth + SkipPhase[i]) / SkipSize[i]) is odd, so helpers spread
+    // over the next few depths instead of searching the main one.
+    constexpr std::array<int, 20> SkipSize{1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+    constexpr std::array<int, 20> SkipPhase{0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
 
-    struct TTEntry
+    struct KillerMoves
     {
-        std::uint64_t key{0};
-        int depth{0};
-        int score{0};
-        NodeType nodeType{NodeType::Exact};
-        Move bestMove{};
-        bool valid{false};
+        Move primary{};
+        Move secondary{};
     };
 
-    using TranspositionTable = std::array<TTEntry, TTSize>;
-    TranspositionTable transpositionTable{};
+    using KillerTable = std::array<KillerMoves, MaxSearchDepth>;
+    using HistoryTable = std::array<std::array<std::array<int, 64>, 64>, 2>;
+    // [moving piece][to][captured piece type]
+    using CaptureHistoryTable = std::array<std::array<std::array<int, 6>, 64>, 13>;
+
+    // Capture history saturates at +-MaxCaptureHistory; the per-update
+    // bonus grows with depth up to MaxCaptureHistoryBonus.
+    constexpr int MaxCaptureHistory = 10'000;
+    constexpr int MaxCaptureHistoryBonus = 1'200;
 
     struct SearchContext
     {
+        TranspositionTable& transpositionTable;
+        KillerTable& killerMoves;
+        HistoryTable& historyHeuristic;
+        CaptureHistoryTable& captureHistory;
         std::chrono::steady_clock::time_point startTime{};
         int timeLimitMs{0};
+        const std::atomic<bool>* stopRequested{nullptr};
         bool stopped{false};
+        TTExchange* exchange{nullptr};
+        std::chrono::steady_clock::time_point lastImport{};
+        LazyEvalStats lazyEval{};
     };
 
-    struct KillerMoves
-    {
-        Move primary{};
-        Move secondary{};
-    };
-
-    std::array<KillerMoves, MaxSearchDepth> killerMoves{};
-    int historyHeuristic[2][64][64]{};
-
     int piece_value(Piece piece)
     {
         switch (piece)
@@ -101,6 +117,23 @@ namespace
         return piece_value(move.capturedPiece) * 10 - piece_value(move.movingPiece);
     }
 
+    int& capture_history_entry(CaptureHistoryTable& table, const Move& move)
+    {
+        const std::size_t capturedType =
+            static_cast<std::size_t>((static_cast<int>(move.capturedPiece) - 1) % 6);
+        return table[static_cast<std::size_t>(move.movingPiece)][static_cast<std::size_t>(move.to)]
+                    [capturedType];
+    }
+
+    // Gravity update: the entry moves towards +-MaxCaptureHistory by a
+    // share of `bonus` that shrinks as it nears the limit, so old results
+    // fade instead of piling up.
+    void update_capture_history(CaptureHistoryTable& table, const Move& move, int bonus)
+    {
+        int& entry = capture_history_entry(table, move);
+        entry += bonus - entry * std::abs(bonus) / MaxCaptureHistory;
+    }
+
     int compute_time_budget_ms(int timeLimitMs)
     {
         if (timeLimitMs <= 0)
@@ -121,8 +154,41 @@ namespace
         return std::min(timeLimitMs - safetyMargin, budget);
     }
 
+    bool skip_iteration(int helperIndex, int depth)
+    {
+        if (helperIndex <= 0)
+        {
+            return false;
+        }
+        const std::size_t row = static_cast<std::size_t>(helperIndex - 1) % SkipSize.size();
+        return ((depth + SkipPhase[row]) / SkipSize[row]) % 2 != 0;
+    }
+
+    void import_shared_entries(SearchContext& context)
+    {
+        if (context.exchange == nullptr)
+        {
+            return;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (now - context.lastImport < std::chrono::milliseconds(ExchangeIntervalMs))
+        {
+            return;
+        }
+        context.exchange->import(context.transpositionTable);
+        context.lastImport = now;
+    }
+
     bool has_time_left(SearchContext& context)
     {
+        TRACE_ZONE_SAMPLED("time check", 4096);
+        if (context.stopRequested != nullptr &&
+            context.stopRequested->load(std::memory_order_relaxed))
+        {
+            context.stopped = true;
+            return false;
+        }
+
         if (context.timeLimitMs <= 0)
         {
             return true;
@@ -167,65 +233,76 @@ namespace
         return score;
     }
 
-    void store_tt(std::uint64_t key,
+    void store_tt(SearchContext& context,
+                  std::uint64_t key,
                   int depth,
                   int ply,
                   int score,
-                  NodeType nodeType,
+                  TTBound bound,
                   const Move& bestMove)
     {
-        const std::size_t index = static_cast<std::size_t>(key % TTSize);
-        TTEntry& entry = transpositionTable[index];
-
-        if (!entry.valid || entry.key != key || depth >= entry.depth)
-        {
-            entry.key = key;
-            entry.depth = depth;
-            entry.score = to_tt_score(score, ply);
-            entry.nodeType = nodeType;
-            entry.bestMove = bestMove;
-            entry.valid = true;
+        TTData entry;
+        entry.move = pack_move(bestMove);
+        // Fail-hard bounds from infinite windows do not fit in 16 bits; any
+        // value past the mate range bounds the same way.
+        entry.score = static_cast<std::int16_t>(
+            std::clamp(to_tt_score(score, ply),
+                       static_cast<int>(std::numeric_limits<std::int16_t>::min()),
+                       static_cast<int>(std::numeric_limits<std::int16_t>::max())));
+        entry.depth = static_cast<std::uint8_t>(depth);
+        entry.bound = bound;
+        context.transpositionTable.store(key, entry);
+        if (context.exchange != nullptr)
+        {
+            context.exchange->publish(key, entry);
         }
     }
 
-    bool probe_tt(std::uint64_t key,
+    bool probe_tt(const TranspositionTable& transpositionTable,
+                  std::uint64_t key,
                   int depth,
                   int alpha,
                   int beta,
                   int ply,
-                  Move& outMove,
+                  std::uint16_t& outMove,
                   int& outScore)
     {
-        const std::size_t index = static_cast<std::size_t>(key % TTSize);
-        const TTEntry& entry = transpositionTable[index];
-
-        if (!entry.valid || entry.key != key)
+        TTData entry;
+        if (!transpositionTable.probe(key, entry))
         {
             return false;
         }
 
-        outMove = entry.bestMove;
+        outMove = entry.move;
         const int ttScore = from_tt_score(entry.score, ply);
 
-        if (entry.depth >= depth)
+        // A proven mate bound holds at any depth: a deeper search cannot
+        // refute "mates at least this fast" or "is mated at least this fast".
+        const bool provenMateBound =
+            (entry.bound == TTBound::Lower && ttScore >= MateThreshold && ttScore <= MateValue) ||
+            (entry.bound == TTBound::Upper && ttScore <= -MateThreshold && ttScore >= -MateValue);
+
+        if (entry.depth >= depth || provenMateBound)
         {
-            switch (entry.nodeType)
+            switch (entry.bound)
             {
-            case NodeType::Exact:
+            case TTBound::Exact:
                 outScore = ttScore;
                 return true;
-            case NodeType::LowerBound:
+            case TTBound::Lower:
                 if (ttScore > alpha)
                 {
                     alpha = ttScore;
                 }
                 break;
-            case NodeType::UpperBound:
+            case TTBound::Upper:
                 if (ttScore < beta)
                 {
                     beta = ttScore;
                 }
                 break;
+            case TTBound::None:
+                break;
             }
 
             if (alpha >= beta)
@@ -251,37 +328,14 @@ namespace
             return false;
         }
 
-        const int targetSquare = move.to;
-        const int targetFile = file_of(targetSquare);
-        const int targetRank = rank_of(targetSquare);
-        const int direction = (mover == Color::White) ? 1 : -1;
-
-        for (int rank = targetRank + direction; rank >= 0 && rank < 8; rank += direction)
+        const Piece enemyPawn = (mover == Color::White) ? Piece::BlackPawn : Piece::WhitePawn;
+        Bitboard span =
+            PassedPawnMasks[static_cast<std::size_t>(mover)][static_cast<std::size_t>(move.to)];
+        while (span != 0)
         {
-            for (int df = -1; df <= 1; ++df)
+            if (board.piece_at(pop_lsb(span)) == enemyPawn)
             {
-                const int file = targetFile + df;
-                if (file < 0 || file > 7)
-                {
-                    continue;
-                }
-
-                const int sq = make_square(file, rank);
-                const Piece target = board.piece_at(sq);
-                if (mover == Color::White)
-                {
-                    if (target == Piece::BlackPawn)
-                    {
-                        return false;
-                    }
-                }
-                else
-                {
-                    if (target == Piece::WhitePawn)
-                    {
-                        return false;
-                    }
-                }
+                return false;
             }
         }
 
@@ -290,35 +344,22 @@ namespace
 
     bool has_non_pawn_material(const Board& board, Color side)
     {
-        const Piece pawn = (side == Color::White) ? Piece::WhitePawn : Piece::BlackPawn;
-        const Piece king = (side == Color::White) ? Piece::WhiteKing : Piece::BlackKing;
-
-        for (int square = 0; square < 64; ++square)
-        {
-            const Piece piece = board.piece_at(square);
-            if (piece == pawn || piece == king || piece == Piece::None)
-            {
-                continue;
-            }
-
-            if ((side == Color::White && is_white_piece(piece)) ||
-                (side == Color::Black && is_black_piece(piece)))
-            {
-                return true;
-            }
-        }
-
-        return false;
+        return (board.pieces(colored_piece(Piece::WhiteKnight, side)) |
+                board.pieces(colored_piece(Piece::WhiteBishop, side)) |
+                board.pieces(colored_piece(Piece::WhiteRook, side)) |
+                board.pieces(colored_piece(Piece::WhiteQueen, side))) != 0;
     }
 
-    void score_and_sort_moves(const Move& ttMove,
+    void score_and_sort_moves(SearchContext& context,
+                              std::uint16_t ttMove,
                               int ply,
                               Color mover,
                               std::vector<Move>& moves)
     {
         const int colorIndex = (mover == Color::White) ? 0 : 1;
         const KillerMoves emptyKillers{};
-        const KillerMoves& killers = (ply < MaxSearchDepth) ? killerMoves[ply] : emptyKillers;
+        const KillerMoves& killers =
+            (ply < MaxSearchDepth) ? context.killerMoves[static_cast<std::size_t>(ply)] : emptyKillers;
 
         std::vector<std::pair<int, Move>> scored;
         scored.reserve(moves.size());
@@ -327,13 +368,15 @@ namespace
         {
             int score = 0;
 
-            if (same_move(move, ttMove))
+            if (ttMove != 0 && pack_move(move) == ttMove)
             {
                 score = 1'000'000;
             }
             else if (is_capture(move))
             {
-                score = 900'000 + mvv_lva(move);
+                // History only reorders captures of similar victims.
+                score = 900'000 + mvv_lva(move) +
+                        capture_history_entry(context.captureHistory, move) / 8;
                 if (is_promotion(move))
                 {
                     score += piece_value(move.promotionPiece);
@@ -353,7 +396,7 @@ namespace
             }
             else
             {
-                score = historyHeuristic[colorIndex][move.from][move.to];
+                score = context.historyHeuristic[colorIndex][move.from][move.to];
             }
 
             scored.emplace_back(score, move);
@@ -387,7 +430,9 @@ namespace
 
         ++nodes;
 
-        int standPat = evaluate(board);
+        // Fail-hard stand pat only compares against the window, so a lazy
+        // score outside it gives the same result.
+        const int standPat = evaluate(board, alpha, beta, &context.lazyEval);
 
         if (standPat >= beta)
         {
@@ -411,7 +456,7 @@ namespace
             }
         }
 
-        score_and_sort_moves(Move{}, ply, board.side_to_move(), captures);
+        score_and_sort_moves(context, 0, ply, board.side_to_move(), captures);
 
         for (const Move& move : captures)
         {
@@ -463,14 +508,32 @@ namespace
 
         ++nodes;
 
+        // A position repeated along the game and search line is scored as
+        // a draw: the side ahead has to find something else. The root
+        // still has to pick a move.
+        if (ply > 0 && board.is_repetition())
+        {
+            return 0;
+        }
+
+        // Mate distance pruning: nothing below can mate faster than a mate
+        // at this ply or be mated later than one here, so once a mate is
+        // known the window collapses for every longer line.
+        alpha = std::max(alpha, -MateValue + ply);
+        beta = std::min(beta, MateValue - ply - 1);
+        if (alpha >= beta)
+        {
+            return alpha;
+        }
+
         const int alphaOriginal = alpha;
         const std::uint64_t key = board.zobrist_key();
         const Color mover = board.side_to_move();
         const bool inCheck = board.is_in_check(mover);
 
-        Move ttMove{};
+        std::uint16_t ttMove = 0;
         int ttScore = 0;
-        if (probe_tt(key, depth, alpha, beta, ply, ttMove, ttScore))
+        if (probe_tt(context.transpositionTable, key, depth, alpha, beta, ply, ttMove, ttScore))
         {
             return ttScore;
         }
@@ -493,175 +556,390 @@ namespace
             }
         }
 
-        std::vector<Move> moves = board.generate_legal_moves();
-
-        if (moves.empty())
-        {
-            if (inCheck)
-            {
-                return -MateValue + ply;
-            }
-            return 0;
-        }
-
-        score_and_sort_moves(ttMove, ply, mover, moves);
-
         int bestScore = -InfinityScore;
         Move bestMove{};
         int moveIndex = 0;
+        // Captures searched without a cutoff, penalised when a later move cuts.
+        std::array<Move, 32> failedCaptures{};
+        std::size_t failedCaptureCount = 0;
 
-        for (const Move& move : moves)
-        {
-            if (context.stopped)
+        const CheckInfo checkInfo = board.position().check_info();
+
+        // Searches one move and updates the node's best score; returns true
+        // on a beta cutoff. The caller checks context.stopped afterwards.
+        const auto search_move =
+            [&](const Move& move)
             {
-                break;
-            }
+                const bool gaveCheck = board.position().gives_check(move, checkInfo);
+                board.make_move(move);
+
+                const bool passedPawnPush = is_passed_pawn_push(board, move, mover);
+                const bool recapture =
+                    is_capture(move) && previousMove.to == move.to && previousMove.to != previousMove.from;
+
+                const int extension = (gaveCheck || passedPawnPush || recapture) ? 1 : 0;
+                int nextDepth = depth - 1 + extension;
+
+                if (!is_capture(move) &&
+                    !is_promotion(move) &&
+                    depth >= 3 &&
+                    moveIndex >= 4 &&
+                    !gaveCheck &&
+                    !recapture &&
+                    pack_move(move) != ttMove)
+                {
+                    --nextDepth;
+                }
 
-            board.make_move(move);
+                if (nextDepth < 0)
+                {
+                    nextDepth = 0;
+                }
+
+                const int score =
+                    -search_impl(board, nextDepth, -beta, -alpha, nodes, context, ply + 1, move);
+
+                board.undo_move();
+
+                if (context.stopped)
+                {
+                    return false;
+                }
+
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    bestMove = move;
+                }
+                if (score > alpha)
+                {
+                    alpha = score;
+                    if (alpha >= beta)
+                    {
+                        const int captureBonus = std::min(depth * depth * 16, MaxCaptureHistoryBonus);
+                        if (is_capture(move))
+                        {
+                            update_capture_history(context.captureHistory, move, captureBonus);
+                        }
+                        for (std::size_t i = 0; i < failedCaptureCount; ++i)
+                        {
+                            update_capture_history(context.captureHistory, failedCaptures[i], -captureBonus);
+                        }
 
-            const bool gaveCheck = board.is_in_check(board.side_to_move());
-            const bool passedPawnPush = is_passed_pawn_push(board, move, mover);
-            const bool recapture =
-                is_capture(move) && previousMove.to == move.to && previousMove.to != previousMove.from;
+                        if (!is_capture(move) && !is_promotion(move) && ply < MaxSearchDepth)
+                        {
+                            KillerMoves& killers = context.killerMoves[static_cast<std::size_t>(ply)];
+                            if (!same_move(move, killers.primary))
+                            {
+                                killers.secondary = killers.primary;
+                                killers.primary = move;
+                            }
+
+                            const int colorIndex = (mover == Color::White) ? 0 : 1;
+                            context.historyHeuristic[colorIndex][move.from][move.to] += depth * depth;
+                        }
 
-            const int extension = (gaveCheck || passedPawnPush || recapture) ? 1 : 0;
-            int nextDepth = depth - 1 + extension;
+                        return true;
+                    }
+                }
 
-            if (!is_capture(move) &&
-                !is_promotion(move) &&
-                depth >= 3 &&
-                moveIndex >= 4 &&
-                !gaveCheck &&
-                !recapture &&
-                !same_move(move, ttMove))
+                if (is_capture(move) && failedCaptureCount < failedCaptures.size())
+                {
+                    failedCaptures[failedCaptureCount++] = move;
+                }
+                ++moveIndex;
+                return false;
+            };
+
+        const auto store_result =
+            [&]()
             {
-                --nextDepth;
-            }
+                TTBound bound = TTBound::Exact;
 
-            if (nextDepth < 0)
+                if (bestScore <= alphaOriginal)
+                {
+                    bound = TTBound::Upper;
+                }
+                else if (bestScore >= beta)
+                {
+                    bound = TTBound::Lower;
+                }
+
+                store_tt(context, key, depth, ply, bestScore, bound, bestMove);
+                return bestScore;
+            };
+
+        // Moves are generated lazily: a hash move that cuts makes the node
+        // return without ever generating, unless ProbCut needs the captures
+        // first.
+        std::vector<Move> moves;
+        bool generated = false;
+        const auto generate =
+            [&]()
             {
-                nextDepth = 0;
-            }
+                generated = true;
+                moves = board.generate_legal_moves();
+                score_and_sort_moves(context, ttMove, ply, mover, moves);
+            };
 
-            const int score =
-                -search_impl(board, nextDepth, -beta, -alpha, nodes, context, ply + 1, move);
+        if (!inCheck && depth >= ProbCutMinDepth && std::abs(beta) < MateThreshold)
+        {
+            generate();
+            const int probCutBeta = beta + ProbCutMargin;
+            const int staticEval = evaluate(board);
+            for (const Move& move : moves)
+            {
+                if (!is_capture(move))
+                {
+                    continue;
+                }
+                const int gain = board.position().see(move);
+                if (gain <= 0 || staticEval + gain < probCutBeta)
+                {
+                    continue;
+                }
 
-            board.undo_move();
+                // Cheap qsearch first; only captures that hold up there get
+                // the reduced-depth verification.
+                board.make_move(move);
+                int score = -quiescence(board, -probCutBeta, -probCutBeta + 1, nodes, context, ply + 1);
+                if (score >= probCutBeta)
+                {
+                    score = -search_impl(board, depth - ProbCutReduction, -probCutBeta,
+                                         -probCutBeta + 1, nodes, context, ply + 1, move);
+                }
+                board.undo_move();
+
+                if (context.stopped)
+                {
+                    return alpha;
+                }
+                if (score >= probCutBeta)
+                {
+                    store_tt(context, key, depth - ProbCutReduction + 1, ply, score, TTBound::Lower, move);
+                    return score;
+                }
+            }
+        }
 
+        Move hashMove;
+        const bool hasHashMove =
+            ttMove != 0 && board.unpack_move(ttMove, hashMove) && board.is_legal(hashMove);
+        if (hasHashMove)
+        {
+            const bool cutoff = search_move(hashMove);
             if (context.stopped)
             {
                 return alpha;
             }
-
-            if (score > bestScore)
+            if (cutoff)
             {
-                bestScore = score;
-                bestMove = move;
+                return store_result();
             }
-            if (score > alpha)
-            {
-                alpha = score;
-                if (alpha >= beta)
-                {
-                    if (!is_capture(move) && !is_promotion(move) && ply < MaxSearchDepth)
-                    {
-                        KillerMoves& killers = killerMoves[ply];
-                        if (!same_move(move, killers.primary))
-                        {
-                            killers.secondary = killers.primary;
-                            killers.primary = move;
-                        }
-
-                        const int colorIndex = (mover == Color::White) ? 0 : 1;
-                        historyHeuristic[colorIndex][move.from][move.to] += depth * depth;
-                    }
+        }
 
-                    break;
-                }
+        if (!generated)
+        {
+            generate();
+        }
+        if (moves.empty())
+        {
+            if (inCheck)
+            {
+                return -MateValue + ply;
             }
+            return 0;
+        }
+        if (hasHashMove)
+        {
+            // Already searched above.
+            moves.erase(std::find_if(moves.begin(), moves.end(),
+                                     [ttMove](const Move& move) { return pack_move(move) == ttMove; }));
+        }
 
-            ++moveIndex;
+        for (const Move& move : moves)
+        {
+            const bool cutoff = search_move(move);
+            if (context.stopped)
+            {
+                return alpha;
+            }
+            if (cutoff)
+            {
+                break;
+            }
         }
 
-        NodeType nodeType = NodeType::Exact;
+        return store_result();
+    }
+}
+
+struct Engine::Tables
+{
+    explicit Tables(std::shared_ptr<TranspositionTable> table)
+        : transpositionTable(std::move(table))
+    {
+    }
+
+    std::shared_ptr<TranspositionTable> transpositionTable;
+    KillerTable killerMoves{};
+    HistoryTable historyHeuristic{};
+    CaptureHistoryTable captureHistory{};
+    TTExchange* exchange{nullptr};
 
-        if (bestScore <= alphaOriginal)
+    void clear_move_ordering()
+    {
+        killerMoves.fill(KillerMoves{});
+        for (auto& colorTable : historyHeuristic)
         {
-            nodeType = NodeType::UpperBound;
+            for (auto& fromTable : colorTable)
+            {
+                fromTable.fill(0);
+            }
         }
-        else if (bestScore >= beta)
+        for (auto& pieceTable : captureHistory)
         {
-            nodeType = NodeType::LowerBound;
+            for (auto& toTable : pieceTable)
+            {
+                toTable.fill(0);
+            }
         }
+    }
 
-        store_tt(key, depth, ply, bestScore, nodeType, bestMove);
+    SearchContext make_context()
+    {
+        SearchContext context{*transpositionTable, killerMoves, historyHeuristic, captureHistory};
+        context.startTime = std::chrono::steady_clock::now();
+        context.exchange = exchange;
+        return context;
+    }
+};
 
-        return bestScore;
+int mate_in_moves(int score) noexcept
+{
+    if (score < MateThreshold && score > -MateThreshold)
+    {
+        return 0;
     }
+    const int plies = MateValue - (score > 0 ? score : -score);
+    const int moves = (plies + 1) / 2;
+    return score > 0 ? moves : -moves;
 }
 
-int search(Board& board, int depth, int alpha, int beta, std::int64_t& nodes)
+Engine::Engine(std::size_t ttEntries)
+    : Engine(std::make_shared<TranspositionTable>(ttEntries))
 {
-    SearchContext context;
-    context.startTime = std::chrono::steady_clock::now();
-    context.timeLimitMs = 0;
-    context.stopped = false;
+}
 
-    return search_impl(board, depth, alpha, beta, nodes, context, 0, Move{});
+Engine::Engine(std::shared_ptr<TranspositionTable> table)
+    : tables_(std::make_unique<Tables>(std::move(table))),
+      infoCallback_(
+          [](const SearchInfo& info)
+          {
+              std::cout << "info depth " << info.depth
+                        << " score " << info.score
+                        << " nodes " << info.nodes
+                        << " nps " << info.nps
+                        << " pv " << info.bestMove.to_uci()
+                        << '\n';
+          })
+{
 }
 
-Move find_best_move(Board& board,
-                    int maxDepth,
-                    int timeLimitMs,
-                    int& outScore,
-                    std::int64_t& outNodes,
-                    int& outDepth,
-                    bool useAbsoluteTime)
+Engine::~Engine() = default;
+Engine::Engine(Engine&&) noexcept = default;
+Engine& Engine::operator=(Engine&&) noexcept = default;
+
+void Engine::set_info_callback(SearchInfoCallback callback)
 {
-    transpositionTable.fill(TTEntry{});
-    killerMoves.fill(KillerMoves{});
+    infoCallback_ = std::move(callback);
+}
 
-    for (auto& colorTable : historyHeuristic)
-    {
-        for (auto& fromTable : colorTable)
-        {
-            std::fill(std::begin(fromTable), std::end(fromTable), 0);
-        }
-    }
+void Engine::clear()
+{
+    tables_->transpositionTable->clear();
+    tables_->clear_move_ordering();
+}
 
-    SearchContext context;
-    context.startTime = std::chrono::steady_clock::now();
-    const int clampedTime = (timeLimitMs > 0) ? timeLimitMs : 0;
-    context.timeLimitMs = useAbsoluteTime ? clampedTime : compute_time_budget_ms(clampedTime);
-    context.stopped = false;
+TranspositionTable& Engine::transposition_table() noexcept
+{
+    return *tables_->transpositionTable;
+}
 
+void Engine::set_exchange(TTExchange* exchange) noexcept
+{
+    tables_->exchange = exchange;
+}
+
+int Engine::search(Board& board, int depth, int alpha, int beta, std::int64_t& nodes)
+{
+    SearchContext context = tables_->make_context();
+    return search_impl(board, depth, alpha, beta, nodes, context, 0, Move{});
+}
+
+SearchResult Engine::find_best_move(Board& board, const SearchLimits& limits)
+{
+    TRACE_ZONE("find_best_move");
+    tables_->clear_move_ordering();
+    tables_->transpositionTable->new_search();
+
+    SearchContext context = tables_->make_context();
+    const int clampedTime = (limits.timeLimitMs > 0) ? limits.timeLimitMs : 0;
+    context.timeLimitMs =
+        limits.useAbsoluteTime ? clampedTime : compute_time_budget_ms(clampedTime);
+    context.stopRequested = limits.stop;
+
+    SearchResult result;
     std::int64_t nodes = 0;
 
     std::vector<Move> rootMoves = board.generate_legal_moves();
     if (rootMoves.empty())
     {
-        outScore = 0;
-        outNodes = 0;
-        outDepth = 0;
-        return Move{};
+        return result;
     }
 
+    const std::size_t lineCount =
+        std::min(static_cast<std::size_t>(std::max(limits.multiPv, 1)), rootMoves.size());
+
+    // Start from the stored move when this position was searched before,
+    // e.g. earlier in the session or preloaded from experience.
     Move globalBestMove = rootMoves.front();
+    TTData rootEntry;
+    if (tables_->transpositionTable->probe(board.zobrist_key(), rootEntry) && rootEntry.move != 0)
+    {
+        for (const Move& move : rootMoves)
+        {
+            if (pack_move(move) == rootEntry.move)
+            {
+                globalBestMove = move;
+                break;
+            }
+        }
+    }
     int globalBestScore = -InfinityScore;
     int bestDepthReached = 0;
 
-    for (int depth = 1; depth <= maxDepth; ++depth)
+    for (int depth = 1; depth <= limits.maxDepth; ++depth)
     {
-        int alpha = -InfinityScore;
-        int beta = InfinityScore;
+        // The last depth is never skipped, so a helper always finishes.
+        if (depth < limits.maxDepth && skip_iteration(limits.helperIndex, depth))
+        {
+            continue;
+        }
+        TRACE_ZONE_VALUE("iteration", depth);
+
+        const int beta = InfinityScore;
 
-        Move bestMoveThisDepth{};
-        int bestScoreThisDepth = -InfinityScore;
+        // Best lines so far this iteration, best first. Until lineCount moves
+        // are scored every move gets a full window; after that a move only
+        // has to beat the worst line it would displace.
+        std::vector<RootMoveScore> lines;
+        lines.reserve(rootMoves.size());
 
         const auto iterStart = std::chrono::steady_clock::now();
         const std::int64_t nodesBefore = nodes;
 
-        score_and_sort_moves(globalBestMove, 0, board.side_to_move(), rootMoves);
+        score_and_sort_moves(context, pack_move(globalBestMove), 0, board.side_to_move(), rootMoves);
 
         for (const Move& move : rootMoves)
         {
@@ -669,7 +947,11 @@ Move find_best_move(Board& board,
             {
                 break;
             }
+            import_shared_entries(context);
 
+            const int alpha = (lines.size() >= lineCount) ? lines[lineCount - 1].score : -InfinityScore;
+
+            TRACE_ZONE_VALUE("root move", pack_move(move));
             board.make_move(move);
             const int score =
                 -search_impl(board, depth - 1, -beta, -alpha, nodes, context, 1, move);
@@ -680,15 +962,15 @@ Move find_best_move(Board& board,
                 break;
             }
 
-            if (score > bestScoreThisDepth)
-            {
-                bestScoreThisDepth = score;
-                bestMoveThisDepth = move;
-            }
-            if (score > alpha)
-            {
-                alpha = score;
-            }
+            const auto position = std::upper_bound(
+                lines.begin(),
+                lines.end(),
+                score,
+                [](int value, const RootMoveScore& line)
+                {
+                    return value > line.score;
+                });
+            lines.insert(position, RootMoveScore{move, score});
         }
 
         const auto iterEnd = std::chrono::steady_clock::now();
@@ -698,18 +980,18 @@ Move find_best_move(Board& board,
         const double seconds = elapsedMs > 0 ? static_cast<double>(elapsedMs) / 1000.0 : 0.001;
         const auto nps = static_cast<std::int64_t>(nodesThisIter / seconds);
 
-        if (!context.stopped && bestScoreThisDepth != -InfinityScore)
+        if (!context.stopped && !lines.empty())
         {
-            globalBestMove = bestMoveThisDepth;
-            globalBestScore = bestScoreThisDepth;
+            lines.resize(std::min(lines.size(), lineCount));
+            globalBestMove = lines.front().move;
+            globalBestScore = lines.front().score;
             bestDepthReached = depth;
+            result.lines = lines;
 
-            std::cout << "info depth " << depth
-                      << " score " << bestScoreThisDepth
-                      << " nodes " << nodes
-                      << " nps " << nps
-                      << " pv " << bestMoveThisDepth.to_uci()
-                      << '\n';
+            if (infoCallback_)
+            {
+                infoCallback_(SearchInfo{depth, globalBestScore, nodes, nps, globalBestMove, lines});
+            }
         }
 
         if (context.stopped)
@@ -718,9 +1000,16 @@ Move find_best_move(Board& board,
         }
     }
 
-    outScore = (globalBestScore == -InfinityScore) ? 0 : globalBestScore;
-    outNodes = nodes;
-    outDepth = bestDepthReached;
+    if (context.exchange != nullptr)
+    {
+        context.exchange->flush();
+    }
+
+    result.bestMove = globalBestMove;
+    result.score = (globalBestScore == -InfinityScore) ? 0 : globalBestScore;
+    result.nodes = nodes;
+    result.depth = bestDepthReached;
+    result.lazyEval = context.lazyEval;
 
-    return globalBestMove;
+    return result;
 }
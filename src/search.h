@@ -1,16 +1,112 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "eval.h"
+#include "move.h"
 
 class Board;
-struct Move;
+class TranspositionTable;
+class TTExchange;
+
+struct SearchLimits
+{
+    int maxDepth{6};
+    int timeLimitMs{0};
+    // When false, timeLimitMs is the remaining clock and the engine budgets
+    // a share of it; when true it is spent as given (UCI movetime).
+    bool useAbsoluteTime{false};
+    // Polled during the search; setting it from another thread stops the
+    // search and returns the best move of the last completed depth.
+    const std::atomic<bool>* stop{nullptr};
+    // Number of best root moves to score exactly.
+    int multiPv{1};
+    // Lazy SMP helper number; helpers (> 0) skip some iterations so they
+    // run ahead of the main search instead of repeating it.
+    int helperIndex{0};
+};
+
+struct RootMoveScore
+{
+    Move move{};
+    int score{0};
+};
+
+// Reported once per completed iteration.
+struct SearchInfo
+{
+    int depth{0};
+    int score{0};
+    std::int64_t nodes{0};
+    std::int64_t nps{0};
+    Move bestMove{};
+    // Best first, up to SearchLimits::multiPv entries.
+    std::vector<RootMoveScore> lines{};
+};
+
+struct SearchResult
+{
+    Move bestMove{};
+    int score{0};
+    std::int64_t nodes{0};
+    int depth{0};
+    std::vector<RootMoveScore> lines{};
+    // Quiescence stand-pat evaluations, and how many the cheap terms settled.
+    LazyEvalStats lazyEval{};
+};
+
+using SearchInfoCallback = std::function<void(const SearchInfo&)>;
+
+// Moves until mate for a search score: positive when the side to move
+// mates, negative when it gets mated, 0 when the score is not a mate.
+int mate_in_moves(int score) noexcept;
+
+// One searcher: owns its move-ordering tables and a transposition table,
+// which may be shared with other engines. Separate Engine objects can search
+// concurrently on separate threads; a single Engine runs one search at a
+// time. The table persists across searches until clear().
+class Engine
+{
+public:
+    static constexpr std::size_t DefaultTTEntries = std::size_t{1} << 20;
+
+    explicit Engine(std::size_t ttEntries = DefaultTTEntries);
+    explicit Engine(std::shared_ptr<TranspositionTable> table);
+    ~Engine();
+
+    Engine(Engine&&) noexcept;
+    Engine& operator=(Engine&&) noexcept;
+    Engine(const Engine&) = delete;
+    Engine& operator=(const Engine&) = delete;
+
+    // Defaults to printing UCI "info depth ..." lines to stdout; pass an
+    // empty callback to stay silent.
+    void set_info_callback(SearchInfoCallback callback);
+
+    SearchResult find_best_move(Board& board, const SearchLimits& limits);
+
+    // Fixed-depth alpha-beta from the current position, without iterative
+    // deepening or a time limit.
+    int search(Board& board, int depth, int alpha, int beta, std::int64_t& nodes);
+
+    // Forgets the transposition table and move-ordering history.
+    void clear();
+
+    [[nodiscard]] TranspositionTable& transposition_table() noexcept;
+
+    // Cluster mode: publish deep entries to `exchange` and periodically
+    // import other processes' entries during find_best_move. The exchange
+    // must outlive its use here; pass nullptr to detach.
+    void set_exchange(TTExchange* exchange) noexcept;
 
-int search(Board& board, int depth, int alpha, int beta, std::int64_t& nodes);
+private:
+    struct Tables;
 
-Move find_best_move(Board& board,
-                    int maxDepth,
-                    int timeLimitMs,
-                    int& outScore,
-                    std::int64_t& outNodes,
-                    int& outDepth,
-                    bool useAbsoluteTime = false);
+    std::unique_ptr<Tables> tables_;
+    SearchInfoCallback infoCallback_;
+};
@@ -0,0 +1,941 @@
+#include "server.h"
+
+#if defined(_WIN32)
+
+#include <iostream>
+
+namespace server
+{
+    int run(const ServerOptions&)
+    {
+        std::cerr << "--serve needs Unix domain sockets and is not available on this platform\n";
+        return 1;
+    }
+}
+
+#else
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "move.h"
+#include "search.h"
+#include "transposition_table.h"
+
+namespace
+{
+    constexpr std::string_view StartPositionFen =
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    constexpr std::size_t MaxRequestBytes = 64 * 1024;
+    constexpr int PollIntervalMs = 200;
+    constexpr int DefaultDepth = 6;
+    constexpr int MaxDepth = 64;
+
+    volatile std::sig_atomic_t stopSignal = 0;
+
+    void on_stop_signal(int)
+    {
+        stopSignal = 1;
+    }
+
+    // Requests are flat JSON objects whose values are strings, numbers or
+    // booleans. Values are kept as text, with string escapes decoded.
+    using JsonFields = std::unordered_map<std::string, std::string>;
+
+    void skip_space(std::string_view text, std::size_t& pos)
+    {
+        while (pos < text.size() &&
+               (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\r' || text[pos] == '\n'))
+        {
+            ++pos;
+        }
+    }
+
+    void append_utf8(std::string& out, unsigned codePoint)
+    {
+        if (codePoint < 0x80)
+        {
+            out += static_cast<char>(codePoint);
+        }
+        else if (codePoint < 0x800)
+        {
+            out += static_cast<char>(0xC0 | (codePoint >> 6));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else
+        {
+            out += static_cast<char>(0xE0 | (codePoint >> 12));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    bool parse_json_string(std::string_view text, std::size_t& pos, std::string& out)
+    {
+        if (pos >= text.size() || text[pos] != '"')
+        {
+            return false;
+        }
+
+        for (++pos; pos < text.size(); ++pos)
+        {
+            const char ch = text[pos];
+            if (ch == '"')
+            {
+                ++pos;
+                return true;
+            }
+            if (ch != '\\')
+            {
+                out += ch;
+                continue;
+            }
+
+            if (++pos >= text.size())
+            {
+                return false;
+            }
+
+            switch (text[pos])
+            {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u':
+            {
+                unsigned codePoint = 0;
+                const char* first = text.data() + pos + 1;
+                const char* last = first + std::min<std::size_t>(4, text.size() - pos - 1);
+                const auto [end, status] = std::from_chars(first, last, codePoint, 16);
+                if (status != std::errc{} || end != first + 4 ||
+                    (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+                {
+                    return false;
+                }
+                append_utf8(out, codePoint);
+                pos += 4;
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    bool parse_json_scalar(std::string_view text, std::size_t& pos, std::string& out)
+    {
+        const std::size_t start = pos;
+        while (pos < text.size() &&
+               (std::isalnum(static_cast<unsigned char>(text[pos])) != 0 ||
+                text[pos] == '-' || text[pos] == '+' || text[pos] == '.'))
+        {
+            ++pos;
+        }
+        out.assign(text.substr(start, pos - start));
+        return pos > start;
+    }
+
+    bool parse_json_object(std::string_view text, JsonFields& fields)
+    {
+        std::size_t pos = 0;
+        skip_space(text, pos);
+        if (pos >= text.size() || text[pos] != '{')
+        {
+            return false;
+        }
+        ++pos;
+
+        skip_space(text, pos);
+        if (pos < text.size() && text[pos] == '}')
+        {
+            ++pos;
+            skip_space(text, pos);
+            return pos == text.size();
+        }
+
+        while (true)
+        {
+            std::string key;
+            std::string value;
+
+            skip_space(text, pos);
+            if (!parse_json_string(text, pos, key))
+            {
+                return false;
+            }
+            skip_space(text, pos);
+            if (pos >= text.size() || text[pos] != ':')
+            {
+                return false;
+            }
+            ++pos;
+            skip_space(text, pos);
+
+            const bool parsed = (pos < text.size() && text[pos] == '"')
+                                    ? parse_json_string(text, pos, value)
+                                    : parse_json_scalar(text, pos, value);
+            if (!parsed)
+            {
+                return false;
+            }
+            fields[std::move(key)] = std::move(value);
+
+            skip_space(text, pos);
+            if (pos < text.size() && text[pos] == ',')
+            {
+                ++pos;
+                continue;
+            }
+            if (pos < text.size() && text[pos] == '}')
+            {
+                ++pos;
+                skip_space(text, pos);
+                return pos == text.size();
+            }
+            return false;
+        }
+    }
+
+    std::string json_string(std::string_view text)
+    {
+        std::string out;
+        out.reserve(text.size() + 2);
+        out += '"';
+        for (char ch : text)
+        {
+            switch (ch)
+            {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(ch) < 0x20)
+                {
+                    static constexpr char Hex[] = "0123456789abcdef";
+                    out += "\\u00";
+                    out += Hex[(ch >> 4) & 0x0F];
+                    out += Hex[ch & 0x0F];
+                }
+                else
+                {
+                    out += ch;
+                }
+                break;
+            }
+        }
+        out += '"';
+        return out;
+    }
+
+    // False when the field is present but not an integer.
+    bool read_int_field(const JsonFields& fields, const std::string& key, int& value)
+    {
+        const auto it = fields.find(key);
+        if (it == fields.end())
+        {
+            return true;
+        }
+
+        const std::string& text = it->second;
+        const auto [end, status] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return status == std::errc{} && end == text.data() + text.size();
+    }
+
+    std::string field_or(const JsonFields& fields, const std::string& key, std::string_view fallback)
+    {
+        const auto it = fields.find(key);
+        return (it != fields.end()) ? it->second : std::string(fallback);
+    }
+
+    // One client socket. Search threads and the connection's reader share
+    // it; the descriptor is closed once the last of them lets go.
+    class Connection
+    {
+    public:
+        explicit Connection(int fd)
+            : fd_(fd)
+        {
+        }
+
+        ~Connection()
+        {
+            ::close(fd_);
+        }
+
+        Connection(const Connection&) = delete;
+        Connection& operator=(const Connection&) = delete;
+
+        [[nodiscard]] int fd() const noexcept
+        {
+            return fd_;
+        }
+
+        // Writes one line; silently dropped once the client has gone.
+        void send_line(const std::string& line)
+        {
+            const std::string framed = line + '\n';
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::size_t sent = 0;
+            while (open_ && sent < framed.size())
+            {
+                const ssize_t written =
+                    ::send(fd_, framed.data() + sent, framed.size() - sent, MSG_NOSIGNAL);
+                if (written < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (written <= 0)
+                {
+                    open_ = false;
+                    break;
+                }
+                sent += static_cast<std::size_t>(written);
+            }
+        }
+
+        // False once a write failed or the session was ended.
+        [[nodiscard]] bool is_open()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return open_;
+        }
+
+        // Ends the session; a blocked reader wakes up with end of file.
+        void shutdown()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            open_ = false;
+            ::shutdown(fd_, SHUT_RDWR);
+        }
+
+    private:
+        int fd_;
+        std::mutex mutex_;
+        bool open_{true};
+    };
+
+    struct Job
+    {
+        std::shared_ptr<Connection> connection;
+        std::string id;
+        Board board;
+        SearchLimits limits;
+        int priority{0};
+        std::uint64_t sequence{0};
+        std::atomic<bool> stop{false};
+    };
+
+    std::string lines_json(const std::vector<RootMoveScore>& lines)
+    {
+        std::ostringstream out;
+        out << '[';
+        for (std::size_t i = 0; i < lines.size(); ++i)
+        {
+            out << (i == 0 ? "" : ",")
+                << "{\"move\":" << json_string(lines[i].move.to_uci())
+                << ",\"score\":" << lines[i].score << '}';
+        }
+        out << ']';
+        return out.str();
+    }
+
+    std::string info_json(const Job& job, const SearchInfo& info)
+    {
+        std::ostringstream out;
+        out << "{\"id\":" << json_string(job.id)
+            << ",\"type\":\"info\""
+            << ",\"depth\":" << info.depth
+            << ",\"nodes\":" << info.nodes
+            << ",\"nps\":" << info.nps
+            << ",\"lines\":" << lines_json(info.lines) << '}';
+        return out.str();
+    }
+
+    std::string result_json(const Job& job, const SearchResult& result)
+    {
+        const bool hasMove = result.bestMove.movingPiece != Piece::None;
+        std::ostringstream out;
+        out << "{\"id\":" << json_string(job.id)
+            << ",\"type\":\"bestmove\""
+            << ",\"move\":" << (hasMove ? json_string(result.bestMove.to_uci()) : "null")
+            << ",\"score\":" << result.score
+            << ",\"depth\":" << result.depth
+            << ",\"nodes\":" << result.nodes
+            << ",\"stopped\":" << (job.stop.load() ? "true" : "false")
+            << ",\"lines\":" << lines_json(result.lines) << '}';
+        return out.str();
+    }
+
+    std::string status_json(std::string_view id, std::string_view type)
+    {
+        return "{\"id\":" + json_string(id) + ",\"type\":" + json_string(type) + '}';
+    }
+
+    std::string error_json(std::string_view id, std::string_view message)
+    {
+        return "{\"id\":" + json_string(id) + ",\"type\":\"error\",\"message\":" +
+               json_string(message) + '}';
+    }
+
+    // Runs queued jobs, highest priority first and FIFO within a priority,
+    // on a fixed set of threads. Every thread's Engine probes and stores
+    // into the same table, so it stays warm across requests.
+    class Scheduler
+    {
+    public:
+        Scheduler(int threadCount, std::shared_ptr<TranspositionTable> table)
+            : table_(std::move(table))
+        {
+            for (int i = 0; i < threadCount; ++i)
+            {
+                workers_.emplace_back([this] { work(); });
+            }
+        }
+
+        ~Scheduler()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                shuttingDown_ = true;
+                queue_.clear();
+                for (const auto& job : running_)
+                {
+                    job->stop = true;
+                }
+            }
+            wake_.notify_all();
+            for (std::thread& worker : workers_)
+            {
+                worker.join();
+            }
+        }
+
+        Scheduler(const Scheduler&) = delete;
+        Scheduler& operator=(const Scheduler&) = delete;
+
+        void submit(std::shared_ptr<Job> job)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                job->sequence = nextSequence_++;
+                queue_.push_back(std::move(job));
+                std::push_heap(queue_.begin(), queue_.end(), runs_later);
+            }
+            wake_.notify_one();
+        }
+
+        // Drops matching queued jobs and stops matching running ones; a
+        // stopped job still reports its best move so far.
+        void cancel(const Connection& connection, const std::string& id)
+        {
+            std::vector<std::shared_ptr<Job>> dropped;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                dropped = take_queued(
+                    [&](const Job& job)
+                    {
+                        return job.connection.get() == &connection && job.id == id;
+                    });
+                for (const auto& job : running_)
+                {
+                    if (job->connection.get() == &connection && job->id == id)
+                    {
+                        job->stop = true;
+                    }
+                }
+            }
+
+            for (const auto& job : dropped)
+            {
+                job->connection->send_line(status_json(job->id, "cancelled"));
+            }
+        }
+
+        // cancel() for every job of the connection.
+        void cancel_connection(const Connection& connection)
+        {
+            std::vector<std::shared_ptr<Job>> dropped;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                dropped = take_queued(
+                    [&](const Job& job)
+                    {
+                        return job.connection.get() == &connection;
+                    });
+                for (const auto& job : running_)
+                {
+                    if (job->connection.get() == &connection)
+                    {
+                        job->stop = true;
+                    }
+                }
+            }
+
+            for (const auto& job : dropped)
+            {
+                job->connection->send_line(status_json(job->id, "cancelled"));
+            }
+        }
+
+        // True while a job of the connection is queued or has not sent its
+        // best move yet.
+        [[nodiscard]] bool has_jobs(const Connection& connection)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto ours = [&](const std::shared_ptr<Job>& job)
+            {
+                return job->connection.get() == &connection;
+            };
+            return std::any_of(queue_.begin(), queue_.end(), ours) ||
+                   std::any_of(running_.begin(), running_.end(), ours);
+        }
+
+        void clear_hash()
+        {
+            table_->clear();
+        }
+
+    private:
+        std::shared_ptr<TranspositionTable> table_;
+        std::vector<std::thread> workers_;
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::vector<std::shared_ptr<Job>> queue_;
+        std::vector<std::shared_ptr<Job>> running_;
+        std::uint64_t nextSequence_{0};
+        bool shuttingDown_{false};
+
+        // Heap order: the job at the front runs first.
+        static bool runs_later(const std::shared_ptr<Job>& lhs, const std::shared_ptr<Job>& rhs)
+        {
+            if (lhs->priority != rhs->priority)
+            {
+                return lhs->priority < rhs->priority;
+            }
+            return lhs->sequence > rhs->sequence;
+        }
+
+        template <typename Predicate>
+        std::vector<std::shared_ptr<Job>> take_queued(Predicate matches)
+        {
+            std::vector<std::shared_ptr<Job>> taken;
+            const auto kept = std::stable_partition(
+                queue_.begin(),
+                queue_.end(),
+                [&](const std::shared_ptr<Job>& job)
+                {
+                    return !matches(*job);
+                });
+            taken.assign(kept, queue_.end());
+            queue_.erase(kept, queue_.end());
+            std::make_heap(queue_.begin(), queue_.end(), runs_later);
+            return taken;
+        }
+
+        std::shared_ptr<Job> next_job()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return shuttingDown_ || !queue_.empty(); });
+            if (shuttingDown_)
+            {
+                return nullptr;
+            }
+
+            std::pop_heap(queue_.begin(), queue_.end(), runs_later);
+            std::shared_ptr<Job> job = std::move(queue_.back());
+            queue_.pop_back();
+            running_.push_back(job);
+            return job;
+        }
+
+        void finish(const std::shared_ptr<Job>& job)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_.erase(std::remove(running_.begin(), running_.end(), job), running_.end());
+        }
+
+        void work()
+        {
+            Engine engine(table_);
+            while (const std::shared_ptr<Job> job = next_job())
+            {
+                engine.set_info_callback(
+                    [&job](const SearchInfo& info)
+                    {
+                        job->connection->send_line(info_json(*job, info));
+                    });
+
+                SearchLimits limits = job->limits;
+                limits.stop = &job->stop;
+                const SearchResult result = engine.find_best_move(job->board, limits);
+
+                job->connection->send_line(result_json(*job, result));
+                finish(job);
+            }
+        }
+    };
+
+    bool apply_uci_moves(Board& board, const std::string& moves, std::string& error)
+    {
+        std::istringstream stream(moves);
+        std::string text;
+        while (stream >> text)
+        {
+            bool applied = false;
+            for (const Move& move : board.generate_legal_moves())
+            {
+                if (move.to_uci() == text)
+                {
+                    board.make_move(move);
+                    applied = true;
+                    break;
+                }
+            }
+            if (!applied)
+            {
+                error = "illegal move: " + text;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool build_job(const JsonFields& fields, Job& job, std::string& error)
+    {
+        FenError fenError;
+        const std::string fen = field_or(fields, "fen", StartPositionFen);
+        if (!job.board.load_fen(fen, &fenError))
+        {
+            error = std::string("invalid fen: ") + fenError.message + " (column " +
+                    std::to_string(fenError.offset + 1) + ")";
+            return false;
+        }
+
+        if (!apply_uci_moves(job.board, field_or(fields, "moves", ""), error))
+        {
+            return false;
+        }
+
+        int depth = 0;
+        int movetime = 0;
+        int multiPv = 1;
+        if (!read_int_field(fields, "depth", depth) ||
+            !read_int_field(fields, "movetime", movetime) ||
+            !read_int_field(fields, "multipv", multiPv) ||
+            !read_int_field(fields, "priority", job.priority))
+        {
+            error = "depth, movetime, multipv and priority must be integers";
+            return false;
+        }
+
+        const int fallbackDepth = (movetime > 0) ? MaxDepth : DefaultDepth;
+        job.limits.maxDepth = (depth > 0) ? std::min(depth, MaxDepth) : fallbackDepth;
+        job.limits.timeLimitMs = std::max(movetime, 0);
+        job.limits.useAbsoluteTime = true;
+        job.limits.multiPv = std::max(multiPv, 1);
+        return true;
+    }
+
+    void handle_request(Scheduler& scheduler,
+                        const std::shared_ptr<Connection>& connection,
+                        std::string_view line)
+    {
+        JsonFields fields;
+        if (!parse_json_object(line, fields))
+        {
+            connection->send_line(error_json("", "request must be a flat JSON object"));
+            return;
+        }
+
+        const std::string id = field_or(fields, "id", "");
+        const std::string command = field_or(fields, "cmd", "analyze");
+
+        if (command == "analyze")
+        {
+            auto job = std::make_shared<Job>();
+            job->connection = connection;
+            job->id = id;
+
+            std::string error;
+            if (!build_job(fields, *job, error))
+            {
+                connection->send_line(error_json(id, error));
+                return;
+            }
+
+            connection->send_line(status_json(id, "queued"));
+            scheduler.submit(std::move(job));
+        }
+        else if (command == "cancel")
+        {
+            scheduler.cancel(*connection, id);
+        }
+        else if (command == "clear")
+        {
+            scheduler.clear_hash();
+            connection->send_line(status_json(id, "cleared"));
+        }
+        else if (command == "ping")
+        {
+            connection->send_line(status_json(id, "pong"));
+        }
+        else
+        {
+            connection->send_line(error_json(id, "unknown cmd: " + command));
+        }
+    }
+
+    // Open sessions, so shutdown can end them and wait for their readers.
+    class SessionSet
+    {
+    public:
+        void add(const std::shared_ptr<Connection>& connection)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            sessions_.erase(
+                std::remove_if(sessions_.begin(),
+                               sessions_.end(),
+                               [](const std::weak_ptr<Connection>& session)
+                               {
+                                   return session.expired();
+                               }),
+                sessions_.end());
+            sessions_.push_back(connection);
+            ++activeReaders_;
+        }
+
+        // Notifies under the lock: once shutdown_all() sees zero readers it
+        // may destroy this set, so no reader may touch it afterwards.
+        void reader_done()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --activeReaders_;
+            idle_.notify_all();
+        }
+
+        void shutdown_all()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            for (const auto& session : sessions_)
+            {
+                if (const auto connection = session.lock())
+                {
+                    connection->shutdown();
+                }
+            }
+            idle_.wait(lock, [this] { return activeReaders_ == 0; });
+        }
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable idle_;
+        std::vector<std::weak_ptr<Connection>> sessions_;
+        int activeReaders_{0};
+    };
+
+    // After the client closed its sending side: waits until the replies to
+    // its requests are out, unless it closes completely, a write fails or
+    // the server shuts down first.
+    void await_replies(Connection& connection, Scheduler& scheduler)
+    {
+        while (connection.is_open() && scheduler.has_jobs(connection))
+        {
+            pollfd peer{connection.fd(), 0, 0};
+            if (::poll(&peer, 1, PollIntervalMs) > 0 && (peer.revents & (POLLHUP | POLLERR)) != 0)
+            {
+                return;
+            }
+        }
+    }
+
+    void serve_connection(std::shared_ptr<Connection> connection,
+                          Scheduler& scheduler,
+                          SessionSet& sessions)
+    {
+        std::string pending;
+        char buffer[4096];
+        bool endOfInput = false;
+
+        while (true)
+        {
+            const ssize_t received = ::read(connection->fd(), buffer, sizeof(buffer));
+            if (received < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (received <= 0)
+            {
+                endOfInput = received == 0;
+                break;
+            }
+            pending.append(buffer, static_cast<std::size_t>(received));
+
+            std::size_t lineStart = 0;
+            for (std::size_t newline = pending.find('\n');
+                 newline != std::string::npos;
+                 newline = pending.find('\n', lineStart))
+            {
+                std::string_view line(pending.data() + lineStart, newline - lineStart);
+                if (!line.empty() && line.back() == '\r')
+                {
+                    line.remove_suffix(1);
+                }
+                if (!line.empty())
+                {
+                    handle_request(scheduler, connection, line);
+                }
+                lineStart = newline + 1;
+            }
+            pending.erase(0, lineStart);
+
+            if (pending.size() > MaxRequestBytes)
+            {
+                connection->send_line(error_json("", "request line too long"));
+                break;
+            }
+        }
+
+        // A half-closed client, e.g. `nc -N` with piped requests, still
+        // gets its answers; whatever is left when it is gone is cancelled.
+        if (endOfInput)
+        {
+            await_replies(*connection, scheduler);
+        }
+        scheduler.cancel_connection(*connection);
+        connection->shutdown();
+        sessions.reader_done();
+    }
+
+    int open_listen_socket(const std::string& path)
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(address.sun_path))
+        {
+            std::cerr << "socket path must be 1-" << sizeof(address.sun_path) - 1 << " bytes\n";
+            return -1;
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+        // Replace a socket left behind by a previous run, but never a file.
+        struct stat existing{};
+        if (::lstat(path.c_str(), &existing) == 0)
+        {
+            if (!S_ISSOCK(existing.st_mode))
+            {
+                std::cerr << path << " exists and is not a socket\n";
+                return -1;
+            }
+            ::unlink(path.c_str());
+        }
+
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+        {
+            std::cerr << "socket: " << std::strerror(errno) << '\n';
+            return -1;
+        }
+
+        if (::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(fd, SOMAXCONN) != 0)
+        {
+            std::cerr << "cannot listen on " << path << ": " << std::strerror(errno) << '\n';
+            ::close(fd);
+            return -1;
+        }
+
+        return fd;
+    }
+}
+
+namespace server
+{
+    int run(const ServerOptions& options)
+    {
+        const int listenFd = open_listen_socket(options.socketPath);
+        if (listenFd < 0)
+        {
+            return 1;
+        }
+
+        std::signal(SIGINT, on_stop_signal);
+        std::signal(SIGTERM, on_stop_signal);
+        std::signal(SIGPIPE, SIG_IGN);
+
+        const int threads =
+            (options.threads > 0)
+                ? options.threads
+                : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        const std::size_t ttEntries =
+            options.hashMb * 1024 * 1024 / sizeof(TranspositionTable::Slot);
+
+        SessionSet sessions;
+        {
+            Scheduler scheduler(threads, std::make_shared<TranspositionTable>(ttEntries));
+
+            std::cout << "serving on " << options.socketPath << " with " << threads
+                      << " search threads and " << options.hashMb << " MB hash\n";
+            std::cout.flush();
+
+            while (stopSignal == 0)
+            {
+                pollfd listener{listenFd, POLLIN, 0};
+                if (::poll(&listener, 1, PollIntervalMs) <= 0)
+                {
+                    continue;
+                }
+
+                const int clientFd = ::accept(listenFd, nullptr, nullptr);
+                if (clientFd < 0)
+                {
+                    continue;
+                }
+
+                auto connection = std::make_shared<Connection>(clientFd);
+                sessions.add(connection);
+                std::thread(serve_connection, connection, std::ref(scheduler), std::ref(sessions))
+                    .detach();
+            }
+
+            ::close(listenFd);
+            ::unlink(options.socketPath.c_str());
+            sessions.shutdown_all();
+        }
+
+        return 0;
+    }
+}
+
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace server
+{
+    struct ServerOptions
+    {
+        std::string socketPath;
+        // Search threads; 0 uses one per hardware thread.
+        int threads{0};
+        std::size_t hashMb{64};
+    };
+
+    // Serves analysis requests on a Unix domain socket until SIGINT/SIGTERM
+    // and returns the process exit code. Each line in is one JSON object:
+    //   {"id":"a","fen":"...","moves":"e2e4 e7e5","depth":12,"movetime":500,
+    //    "multipv":3,"priority":1}      analyze (all fields optional)
+    //   {"cmd":"cancel","id":"a"}     drop it if queued, stop it if running
+    //   {"cmd":"clear"} / {"cmd":"ping"}
+    // Replies are JSON lines whose "type" is queued, info, bestmove,
+    // cancelled, cleared, pong or error, tagged with the request id. A
+    // client may shut down its sending side after the last request and
+    // still read every reply; closing the socket cancels what is left.
+    int run(const ServerOptions& options);
+}
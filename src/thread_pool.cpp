@@ -0,0 +1,215 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+    // Enough chunks per thread that a slow one can be stolen around.
+    constexpr std::size_t ChunksPerThread = 4;
+
+    // The pool and slot of the current thread while it is a worker.
+    thread_local const ThreadPool* currentPool = nullptr;
+    thread_local int currentIndex = 0;
+
+    void pin_to_cpu(std::thread& thread, int cpu)
+    {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(static_cast<unsigned>(cpu) % CPU_SETSIZE, &set);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+        (void)thread;
+        (void)cpu;
+#endif
+    }
+}
+
+ThreadPool::ThreadPool(int threads, bool pinThreads)
+{
+    const int count = threads > 0 ? threads : hardware_threads();
+    for (int i = 0; i < count; ++i)
+    {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    for (int i = 1; i < count; ++i)
+    {
+        workers_.emplace_back(&ThreadPool::worker_loop, this, i);
+        if (pinThreads)
+        {
+            pin_to_cpu(workers_.back(), i);
+        }
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallel_for(std::size_t begin,
+                              std::size_t end,
+                              const std::function<void(std::size_t)>& body)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    const std::size_t count = end - begin;
+    const std::size_t chunks = std::min(count, static_cast<std::size_t>(size()) * ChunksPerThread);
+    const std::size_t chunkSize = (count + chunks - 1) / chunks;
+    const std::size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+    const int index = thread_index();
+
+    Group group;
+    group.pending.store(chunkCount, std::memory_order_relaxed);
+
+    // Queued back to front so the caller, popping from the back, starts
+    // with the first chunk while thieves take the last ones.
+    for (std::size_t chunk = chunkCount; chunk-- > 0;)
+    {
+        const std::size_t first = begin + chunk * chunkSize;
+        const std::size_t last = std::min(first + chunkSize, end);
+        push(index,
+             Task{[&body, first, last]()
+                  {
+                      for (std::size_t i = first; i < last; ++i)
+                      {
+                          body(i);
+                      }
+                  },
+                  &group});
+    }
+
+    // Help out until every chunk of this loop is done. The tasks run here
+    // may belong to other loops; that only makes the wait shorter for them.
+    while (group.pending.load(std::memory_order_acquire) > 0)
+    {
+        Task task;
+        if (pop_or_steal(index, task))
+        {
+            run_task(task);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    if (group.error)
+    {
+        std::rethrow_exception(group.error);
+    }
+}
+
+int ThreadPool::size() const noexcept
+{
+    return static_cast<int>(queues_.size());
+}
+
+int ThreadPool::thread_index() const noexcept
+{
+    return currentPool == this ? currentIndex : 0;
+}
+
+int ThreadPool::hardware_threads() noexcept
+{
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+void ThreadPool::worker_loop(int index)
+{
+    currentPool = this;
+    currentIndex = index;
+
+    for (;;)
+    {
+        Task task;
+        if (pop_or_steal(index, task))
+        {
+            run_task(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wake_.wait(lock, [this]() { return stopping_ || queued_.load(std::memory_order_acquire) > 0; });
+        if (stopping_)
+        {
+            return;
+        }
+    }
+}
+
+void ThreadPool::push(int index, Task task)
+{
+    {
+        // Counted under the sleep lock so a worker about to wait sees it,
+        // and before the push so a thief never takes the count below zero.
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        queued_.fetch_add(1, std::memory_order_release);
+    }
+    Queue& queue = *queues_[static_cast<std::size_t>(index)];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    wake_.notify_one();
+}
+
+bool ThreadPool::pop_or_steal(int index, Task& task)
+{
+    const std::size_t count = queues_.size();
+    for (std::size_t offset = 0; offset < count; ++offset)
+    {
+        Queue& queue = *queues_[(static_cast<std::size_t>(index) + offset) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+        {
+            continue;
+        }
+        if (offset == 0)
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run_task(Task& task)
+{
+    try
+    {
+        task.run();
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(task.group->errorMutex);
+        if (!task.group->error)
+        {
+            task.group->error = std::current_exception();
+        }
+    }
+    task.group->pending.fetch_sub(1, std::memory_order_acq_rel);
+}
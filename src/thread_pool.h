@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing task scheduler shared by the parallel tools. Every
+// participating thread owns a deque: it pushes and pops its own work at the
+// back and, when that runs dry, steals from the front of the others'. The
+// thread that calls parallel_for() takes part too, on deque 0, and keeps
+// running tasks until its loop is finished, so a task may itself call
+// parallel_for() without tying up a worker.
+class ThreadPool
+{
+public:
+    // `threads` counts the caller, so 1 runs everything inline and 0 uses
+    // every hardware thread. With `pinThreads`, worker i is bound to CPU i
+    // where the platform supports it.
+    explicit ThreadPool(int threads = 0, bool pinThreads = false);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Calls body(i) for every i in [begin, end), spread over the pool, and
+    // returns once all calls have finished. The first exception thrown by
+    // a call is rethrown here after the rest have run.
+    void parallel_for(std::size_t begin, std::size_t end, const std::function<void(std::size_t)>& body);
+
+    [[nodiscard]] int size() const noexcept;
+
+    // Slot of the calling thread in [0, size()): its worker number, or 0
+    // for any thread outside the pool. Lets tasks index per-thread state,
+    // as long as a single outside thread drives the pool.
+    [[nodiscard]] int thread_index() const noexcept;
+
+    [[nodiscard]] static int hardware_threads() noexcept;
+
+private:
+    struct Group
+    {
+        std::atomic<std::size_t> pending{0};
+        std::mutex errorMutex;
+        std::exception_ptr error;
+    };
+
+    struct Task
+    {
+        std::function<void()> run;
+        Group* group{nullptr};
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void worker_loop(int index);
+    void push(int index, Task task);
+    bool pop_or_steal(int index, Task& task);
+    static void run_task(Task& task);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+
+    // Tasks sitting in any deque; idle workers sleep while it is zero.
+    std::atomic<std::size_t> queued_{0};
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    bool stopping_{false};
+};
@@ -0,0 +1,217 @@
+#include "trace.h"
+
+#if defined(CHESS_TRACE)
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    struct Event
+    {
+        const char* name{nullptr};
+        std::int64_t value{0};
+        std::uint64_t startNs{0};
+        std::uint64_t durationNs{0};
+    };
+
+    // Written only by its thread; `written` publishes each event to the
+    // exporter. Kept alive by the registry after the thread exits.
+    struct ThreadBuffer
+    {
+        int tid{0};
+        std::string name;
+        std::vector<Event> events = std::vector<Event>(trace::RingCapacity);
+        std::atomic<std::uint64_t> written{0};
+    };
+
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    };
+
+    Registry& registry()
+    {
+        static Registry instance;
+        return instance;
+    }
+
+    ThreadBuffer& local_buffer()
+    {
+        thread_local const std::shared_ptr<ThreadBuffer> buffer = []()
+        {
+            auto created = std::make_shared<ThreadBuffer>();
+            Registry& all = registry();
+            std::lock_guard<std::mutex> lock(all.mutex);
+            created->tid = static_cast<int>(all.buffers.size()) + 1;
+            created->name = "thread " + std::to_string(created->tid);
+            all.buffers.push_back(created);
+            return created;
+        }();
+        return *buffer;
+    }
+
+    std::uint64_t now_ns() noexcept
+    {
+        static const auto epoch = std::chrono::steady_clock::now();
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch)
+                .count());
+    }
+
+    void write_json_string(std::ostream& out, const std::string& text)
+    {
+        out << '"';
+        for (const char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out << '\\' << c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                out << escaped;
+            }
+            else
+            {
+                out << c;
+            }
+        }
+        out << '"';
+    }
+
+    // Trace timestamps are in microseconds; keep the nanoseconds.
+    void write_microseconds(std::ostream& out, std::uint64_t ns)
+    {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%llu.%03llu",
+                      static_cast<unsigned long long>(ns / 1000),
+                      static_cast<unsigned long long>(ns % 1000));
+        out << text;
+    }
+}
+
+namespace trace
+{
+    bool enabled() noexcept
+    {
+        return true;
+    }
+
+    void set_thread_name(const char* name)
+    {
+        ThreadBuffer& buffer = local_buffer();
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        buffer.name = name;
+    }
+
+    bool write_chrome_json(const std::string& path, std::string& error)
+    {
+        std::ofstream out(path, std::ios::trunc);
+        if (!out)
+        {
+            error = "cannot open " + path;
+            return false;
+        }
+
+        Registry& all = registry();
+        std::lock_guard<std::mutex> lock(all.mutex);
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        for (const auto& buffer : all.buffers)
+        {
+            out << (first ? "\n" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":"
+                << buffer->tid << ",\"args\":{\"name\":";
+            write_json_string(out, buffer->name);
+            out << "}}";
+            first = false;
+
+            const std::uint64_t written = buffer->written.load(std::memory_order_acquire);
+            const std::uint64_t oldest = written > RingCapacity ? written - RingCapacity : 0;
+            for (std::uint64_t i = oldest; i < written; ++i)
+            {
+                const Event& event = buffer->events[static_cast<std::size_t>(i % RingCapacity)];
+                out << ",\n{\"ph\":\"X\",\"name\":";
+                write_json_string(out, event.name);
+                out << ",\"pid\":1,\"tid\":" << buffer->tid << ",\"ts\":";
+                write_microseconds(out, event.startNs);
+                out << ",\"dur\":";
+                write_microseconds(out, event.durationNs);
+                if (event.value != Zone::NoValue)
+                {
+                    out << ",\"args\":{\"value\":" << event.value << '}';
+                }
+                out << '}';
+            }
+        }
+        out << "\n]}\n";
+
+        out.flush();
+        if (!out)
+        {
+            error = "cannot write " + path;
+            return false;
+        }
+        return true;
+    }
+
+    Zone::Zone(const char* name, std::int64_t value) noexcept
+        : name_(name), value_(value), startNs_(name != nullptr ? now_ns() : 0)
+    {
+    }
+
+    Zone::~Zone()
+    {
+        end();
+    }
+
+    void Zone::end() noexcept
+    {
+        if (name_ == nullptr)
+        {
+            return;
+        }
+
+        ThreadBuffer& buffer = local_buffer();
+        const std::uint64_t index = buffer.written.load(std::memory_order_relaxed);
+        Event& event = buffer.events[static_cast<std::size_t>(index % RingCapacity)];
+        event.name = name_;
+        event.value = value_;
+        event.startNs = startNs_;
+        event.durationNs = now_ns() - startNs_;
+        buffer.written.store(index + 1, std::memory_order_release);
+        name_ = nullptr;
+    }
+}
+
+#else
+
+namespace trace
+{
+    bool enabled() noexcept
+    {
+        return false;
+    }
+
+    void set_thread_name(const char*)
+    {
+    }
+
+    bool write_chrome_json(const std::string&, std::string& error)
+    {
+        error = "tracing is compiled out; configure with -DCHESS_TRACE=ON";
+        return false;
+    }
+}
+
+#endif
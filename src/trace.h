@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+// Scoped timing zones for seeing where the time inside a move goes. Every
+// thread records its finished zones into its own ring buffer, which keeps
+// the most recent trace::RingCapacity of them, and write_chrome_json()
+// exports all buffers as Chrome trace_event JSON for chrome://tracing or
+// ui.perfetto.dev. Zones are compiled in only when the build is configured
+// with -DCHESS_TRACE=ON; otherwise the TRACE_* macros expand to nothing.
+namespace trace
+{
+    inline constexpr std::size_t RingCapacity = std::size_t{1} << 16;
+
+    // True when this build records zones.
+    [[nodiscard]] bool enabled() noexcept;
+
+    // Names the calling thread in the exported trace.
+    void set_thread_name(const char* name);
+
+    // Writes every buffered zone of every thread to `path`. Call it while
+    // the traced threads are idle. Returns false and sets `error` on
+    // failure, or when zones are compiled out.
+    bool write_chrome_json(const std::string& path, std::string& error);
+
+#if defined(CHESS_TRACE)
+    // Records the time from construction to end() or destruction under
+    // `name`, which must outlive the export (a string literal). A null name
+    // records nothing. `value` shows up as the zone's argument.
+    class Zone
+    {
+    public:
+        static constexpr std::int64_t NoValue = std::numeric_limits<std::int64_t>::min();
+
+        explicit Zone(const char* name, std::int64_t value = NoValue) noexcept;
+        ~Zone();
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+        void end() noexcept;
+
+    private:
+        const char* name_;
+        std::int64_t value_;
+        std::uint64_t startNs_;
+    };
+#endif
+}
+
+#define CHESS_TRACE_CONCAT_INNER(a, b) a##b
+#define CHESS_TRACE_CONCAT(a, b) CHESS_TRACE_CONCAT_INNER(a, b)
+
+#if defined(CHESS_TRACE)
+// Zone covering the rest of the enclosing scope.
+#define TRACE_ZONE(name) trace::Zone CHESS_TRACE_CONCAT(traceZone_, __LINE__)(name)
+#define TRACE_ZONE_VALUE(name, value) trace::Zone CHESS_TRACE_CONCAT(traceZone_, __LINE__)(name, value)
+// Zone on a hot path: only every `period`-th pass through it is recorded.
+#define TRACE_ZONE_SAMPLED(name, period)                                                       \
+    static thread_local std::uint32_t CHESS_TRACE_CONCAT(traceCounter_, __LINE__) = 0;          \
+    trace::Zone CHESS_TRACE_CONCAT(traceZone_, __LINE__)(                                       \
+        ++CHESS_TRACE_CONCAT(traceCounter_, __LINE__) % (period) == 0 ? (name) : nullptr)
+// Zone that ends before its scope does, at TRACE_ZONE_END(var).
+#define TRACE_NAMED_ZONE(var, name) trace::Zone var(name)
+#define TRACE_ZONE_END(var) var.end()
+#else
+#define TRACE_ZONE(name) static_cast<void>(0)
+#define TRACE_ZONE_VALUE(name, value) static_cast<void>(0)
+#define TRACE_ZONE_SAMPLED(name, period) static_cast<void>(0)
+#define TRACE_NAMED_ZONE(var, name) static_cast<void>(0)
+#define TRACE_ZONE_END(var) static_cast<void>(0)
+#endif
@@ -0,0 +1,387 @@
+#include "transposition_table.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "zobrist.h"
+
+namespace
+{
+    // data layout: move 0-15, score 16-31, depth 32-39, bound 40-47,
+    // generation 48-55. An empty slot is all zero, i.e. TTBound::None.
+    std::uint64_t pack_entry(const TTData& entry)
+    {
+        return static_cast<std::uint64_t>(entry.move) |
+               (static_cast<std::uint64_t>(static_cast<std::uint16_t>(entry.score)) << 16) |
+               (static_cast<std::uint64_t>(entry.depth) << 32) |
+               (static_cast<std::uint64_t>(entry.bound) << 40) |
+               (static_cast<std::uint64_t>(entry.generation) << 48);
+    }
+
+    // Snapshot file: this header, then one {keyXorData, data} pair of
+    // native-endian uint64 per slot.
+    struct SnapshotHeader
+    {
+        char magic[8];
+        std::uint32_t formatVersion;
+        std::uint32_t byteOrderMark;
+        std::uint64_t slotCount;
+        std::uint64_t zobristSeed;
+        std::uint64_t zobristFingerprint;
+        std::uint8_t generation;
+        std::uint8_t reserved[7];
+    };
+
+    constexpr char SnapshotMagic[8] = {'C', 'H', 'E', 'S', 'S', 'T', 'T', '\0'};
+    constexpr std::uint32_t SnapshotFormatVersion = 1;
+    constexpr std::uint32_t ByteOrderMark = 0x01020304;
+
+    const char* check_header(const SnapshotHeader& header, std::size_t fileSize)
+    {
+        if (std::memcmp(header.magic, SnapshotMagic, sizeof(SnapshotMagic)) != 0)
+        {
+            return "not a hash snapshot";
+        }
+        if (header.formatVersion != SnapshotFormatVersion || header.byteOrderMark != ByteOrderMark)
+        {
+            return "snapshot format or byte order differs";
+        }
+        if (header.zobristSeed != ZobristSeed || header.zobristFingerprint != ZobristFingerprint)
+        {
+            return "snapshot was written with different Zobrist keys";
+        }
+        if (header.slotCount == 0 ||
+            header.slotCount > (fileSize - sizeof(SnapshotHeader)) / (2 * sizeof(std::uint64_t)) ||
+            fileSize != sizeof(SnapshotHeader) + header.slotCount * 2 * sizeof(std::uint64_t))
+        {
+            return "snapshot size does not match its header";
+        }
+        return nullptr;
+    }
+
+    TTData unpack_entry(std::uint64_t data)
+    {
+        TTData entry;
+        entry.move = static_cast<std::uint16_t>(data);
+        entry.score = static_cast<std::int16_t>(static_cast<std::uint16_t>(data >> 16));
+        entry.depth = static_cast<std::uint8_t>(data >> 32);
+        entry.bound = static_cast<TTBound>(static_cast<std::uint8_t>(data >> 40));
+        entry.generation = static_cast<std::uint8_t>(data >> 48);
+        return entry;
+    }
+
+    // Replacement rule shared by the local table and the exchange: a new
+    // entry replaces the slot unless it holds a deeper one for the same key.
+    void write_slot(TranspositionTable::Slot& slot, std::uint64_t key, std::uint64_t data) noexcept
+    {
+        const std::uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+        const std::uint64_t oldKey = slot.keyXorData.load(std::memory_order_relaxed) ^ oldData;
+
+        if (oldData != 0 && oldKey == key &&
+            unpack_entry(data).depth < unpack_entry(oldData).depth)
+        {
+            return;
+        }
+
+        slot.keyXorData.store(key ^ data, std::memory_order_relaxed);
+        slot.data.store(data, std::memory_order_relaxed);
+    }
+}
+
+TranspositionTable::TranspositionTable(std::size_t entries)
+    : slots_(std::make_unique<Slot[]>(std::max<std::size_t>(entries, 1))),
+      size_(std::max<std::size_t>(entries, 1))
+{
+}
+
+bool TranspositionTable::probe(std::uint64_t key, TTData& out) const noexcept
+{
+    const Slot& slot = slots_[key % size_];
+    const std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+    const std::uint64_t keyXorData = slot.keyXorData.load(std::memory_order_relaxed);
+
+    if (data == 0 || (keyXorData ^ data) != key)
+    {
+        return false;
+    }
+
+    out = unpack_entry(data);
+    return true;
+}
+
+void TranspositionTable::store(std::uint64_t key, const TTData& entry) noexcept
+{
+    TTData stamped = entry;
+    stamped.generation = generation_.load(std::memory_order_relaxed);
+    write_slot(slots_[key % size_], key, pack_entry(stamped));
+}
+
+bool TranspositionTable::store_if_better(std::uint64_t key, const TTData& entry) noexcept
+{
+    Slot& slot = slots_[key % size_];
+    const std::uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+    const std::uint8_t current = generation_.load(std::memory_order_relaxed);
+    if (oldData != 0)
+    {
+        const TTData old = unpack_entry(oldData);
+        const bool sameKey = (slot.keyXorData.load(std::memory_order_relaxed) ^ oldData) == key;
+        if (old.depth >= entry.depth && (sameKey || old.generation == current))
+        {
+            return false;
+        }
+    }
+
+    TTData stamped = entry;
+    stamped.generation = current;
+    write_slot(slot, key, pack_entry(stamped));
+    return true;
+}
+
+void TranspositionTable::clear() noexcept
+{
+    for (std::size_t i = 0; i < size_; ++i)
+    {
+        slots_[i].keyXorData.store(0, std::memory_order_relaxed);
+        slots_[i].data.store(0, std::memory_order_relaxed);
+    }
+    generation_.store(0, std::memory_order_relaxed);
+}
+
+void TranspositionTable::new_search() noexcept
+{
+    generation_.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::size_t TranspositionTable::size() const noexcept
+{
+    return size_;
+}
+
+std::uint8_t TranspositionTable::generation() const noexcept
+{
+    return generation_.load(std::memory_order_relaxed);
+}
+
+bool TranspositionTable::save(const std::string& path, std::string& error) const
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        error = "cannot open " + path + " for writing";
+        return false;
+    }
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SnapshotMagic, sizeof(SnapshotMagic));
+    header.formatVersion = SnapshotFormatVersion;
+    header.byteOrderMark = ByteOrderMark;
+    header.slotCount = size_;
+    header.zobristSeed = ZobristSeed;
+    header.zobristFingerprint = ZobristFingerprint;
+    header.generation = generation();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Copy out through a buffer: slots are atomics, not plain words.
+    constexpr std::size_t ChunkSlots = 4096;
+    std::vector<std::uint64_t> chunk;
+    chunk.reserve(2 * ChunkSlots);
+    for (std::size_t first = 0; first < size_ && out; first += ChunkSlots)
+    {
+        chunk.clear();
+        const std::size_t last = std::min(size_, first + ChunkSlots);
+        for (std::size_t i = first; i < last; ++i)
+        {
+            chunk.push_back(slots_[i].keyXorData.load(std::memory_order_relaxed));
+            chunk.push_back(slots_[i].data.load(std::memory_order_relaxed));
+        }
+        out.write(reinterpret_cast<const char*>(chunk.data()),
+                  static_cast<std::streamsize>(chunk.size() * sizeof(std::uint64_t)));
+    }
+
+    out.close();
+    if (!out)
+    {
+        error = "failed writing " + path;
+        return false;
+    }
+    return true;
+}
+
+bool TranspositionTable::load(const std::string& path, std::string& error)
+{
+#if !defined(_WIN32)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        error = "cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat info{};
+    if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(SnapshotHeader))
+    {
+        ::close(fd);
+        error = path + " is too short to be a hash snapshot";
+        return false;
+    }
+
+    const std::size_t fileSize = static_cast<std::size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        error = "cannot map " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    const auto* bytes = static_cast<const unsigned char*>(mapping);
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in)
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+    const std::size_t fileSize = static_cast<std::size_t>(in.tellg());
+    std::vector<unsigned char> contents(fileSize);
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(contents.data()), static_cast<std::streamsize>(fileSize));
+    if (!in || fileSize < sizeof(SnapshotHeader))
+    {
+        error = path + " is too short to be a hash snapshot";
+        return false;
+    }
+    const unsigned char* bytes = contents.data();
+#endif
+
+    SnapshotHeader header{};
+    std::memcpy(&header, bytes, sizeof(header));
+    const char* problem = check_header(header, fileSize);
+
+    if (problem == nullptr)
+    {
+        const unsigned char* words = bytes + sizeof(SnapshotHeader);
+        const auto read_word =
+            [words](std::size_t index)
+            {
+                std::uint64_t word = 0;
+                std::memcpy(&word, words + index * sizeof(word), sizeof(word));
+                return word;
+            };
+
+        clear();
+        for (std::size_t i = 0; i < header.slotCount; ++i)
+        {
+            const std::uint64_t keyXorData = read_word(2 * i);
+            const std::uint64_t data = read_word(2 * i + 1);
+            if (data == 0)
+            {
+                continue;
+            }
+
+            // Same-size files land in the same slot; otherwise rehash and
+            // keep the deeper of two colliding entries.
+            const std::uint64_t key = keyXorData ^ data;
+            Slot& slot = slots_[(header.slotCount == size_) ? i : key % size_];
+            const std::uint64_t existing = slot.data.load(std::memory_order_relaxed);
+            if (existing != 0 && unpack_entry(existing).depth > unpack_entry(data).depth)
+            {
+                continue;
+            }
+            slot.keyXorData.store(keyXorData, std::memory_order_relaxed);
+            slot.data.store(data, std::memory_order_relaxed);
+        }
+        generation_.store(header.generation, std::memory_order_relaxed);
+    }
+
+#if !defined(_WIN32)
+    ::munmap(mapping, fileSize);
+#endif
+
+    if (problem != nullptr)
+    {
+        error = problem;
+        return false;
+    }
+    return true;
+}
+
+TTExchange::TTExchange(TranspositionTable::Slot* slots,
+                       std::size_t size,
+                       std::uint8_t minDepth) noexcept
+    : slots_(slots), size_(std::max<std::size_t>(size, 1)), minDepth_(minDepth)
+{
+}
+
+void TTExchange::publish(std::uint64_t key, const TTData& entry) noexcept
+{
+    if (entry.depth < minDepth_)
+    {
+        return;
+    }
+
+    // Generation is local to each process's table; the importer stamps its own.
+    TTData unstamped = entry;
+    unstamped.generation = 0;
+    pendingKeys_[pending_] = key;
+    pendingData_[pending_] = pack_entry(unstamped);
+    if (++pending_ == BatchSize)
+    {
+        flush();
+    }
+}
+
+void TTExchange::flush() noexcept
+{
+    for (std::size_t i = 0; i < pending_; ++i)
+    {
+        write_slot(slots_[pendingKeys_[i] % size_], pendingKeys_[i], pendingData_[i]);
+    }
+    pending_ = 0;
+}
+
+std::size_t TTExchange::import(TranspositionTable& table) noexcept
+{
+    flush();
+
+    std::size_t copied = 0;
+    for (std::size_t i = 0; i < size_; ++i)
+    {
+        const std::uint64_t data = slots_[i].data.load(std::memory_order_relaxed);
+        if (data == 0)
+        {
+            continue;
+        }
+        const std::uint64_t key = slots_[i].keyXorData.load(std::memory_order_relaxed) ^ data;
+
+        // A torn slot hashes elsewhere; skip it rather than store garbage.
+        if (key % size_ != i)
+        {
+            continue;
+        }
+        if (table.store_if_better(key, unpack_entry(data)))
+        {
+            ++copied;
+        }
+    }
+    return copied;
+}
+
+void TTExchange::clear() noexcept
+{
+    pending_ = 0;
+    for (std::size_t i = 0; i < size_; ++i)
+    {
+        slots_[i].keyXorData.store(0, std::memory_order_relaxed);
+        slots_[i].data.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+enum class TTBound : std::uint8_t
+{
+    None,
+    Exact,
+    Lower,
+    Upper
+};
+
+// One probe result. `move` is a pack_move() value (0 when unknown) and
+// `score` is stored relative to the node, as search hands it in.
+struct TTData
+{
+    std::uint16_t move{0};
+    std::int16_t score{0};
+    std::uint8_t depth{0};
+    TTBound bound{TTBound::None};
+    std::uint8_t generation{0};
+};
+
+// Hash table shared by any number of searching threads. Each slot holds the
+// packed entry and the key xor'ed with it, both written with relaxed atomics;
+// a torn write from two racing threads then fails the key check on probe
+// instead of returning a mixed entry.
+class TranspositionTable
+{
+public:
+    struct Slot
+    {
+        std::atomic<std::uint64_t> keyXorData{0};
+        std::atomic<std::uint64_t> data{0};
+    };
+
+    explicit TranspositionTable(std::size_t entries);
+
+    bool probe(std::uint64_t key, TTData& out) const noexcept;
+    // Keeps an existing entry for the same key when it is deeper.
+    void store(std::uint64_t key, const TTData& entry) noexcept;
+    // Stores an entry found elsewhere only where it costs nothing: into an
+    // empty slot, over an entry from an older search, or over a shallower
+    // one. Returns whether it was stored.
+    bool store_if_better(std::uint64_t key, const TTData& entry) noexcept;
+
+    void clear() noexcept;
+    // Starts a new search; entries stored from now on carry the new value.
+    void new_search() noexcept;
+
+    [[nodiscard]] std::size_t size() const noexcept;
+    [[nodiscard]] std::uint8_t generation() const noexcept;
+
+    // Snapshot to disk. load() maps the file and copies its entries in,
+    // rehashing when the file was saved from a table of another size; it
+    // rejects files written with a different format or Zobrist keys. Both
+    // return false and set `error` on failure, leaving the table unchanged
+    // if the file is rejected.
+    bool save(const std::string& path, std::string& error) const;
+    bool load(const std::string& path, std::string& error);
+
+private:
+    std::unique_ptr<Slot[]> slots_;
+    std::size_t size_{0};
+    std::atomic<std::uint8_t> generation_{0};
+};
+
+// One process's view of a slot array that several processes map (cluster
+// mode). Deep entries stored by this process's search are queued and
+// written out in batches; import() copies what the other processes wrote
+// into the local table. Not thread-safe: use one per searching engine.
+class TTExchange
+{
+public:
+    static constexpr std::size_t BatchSize = 64;
+
+    // `slots` must stay mapped for the lifetime of the exchange.
+    TTExchange(TranspositionTable::Slot* slots, std::size_t size, std::uint8_t minDepth) noexcept;
+
+    // Queues the entry if it is at least minDepth deep; flushes when the
+    // batch is full.
+    void publish(std::uint64_t key, const TTData& entry) noexcept;
+    void flush() noexcept;
+
+    // Flushes, then offers every shared entry to `table` through
+    // store_if_better() and returns how many it took.
+    std::size_t import(TranspositionTable& table) noexcept;
+
+    // Empties the shared slots; only call while no other process writes.
+    void clear() noexcept;
+
+private:
+    TranspositionTable::Slot* slots_;
+    std::size_t size_;
+    std::uint8_t minDepth_;
+    std::size_t pending_{0};
+    std::uint64_t pendingKeys_[BatchSize]{};
+    std::uint64_t pendingData_[BatchSize]{};
+};
@@ -1,20 +1,31 @@
 #include "uci.h"
 
+#include <algorithm>
 #include <cctype>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <vector>
 
 #include "board.h"
+#include "cluster.h"
+#include "experience.h"
+#include "mate_search.h"
 #include "move.h"
 #include "search.h"
+#include "transposition_table.h"
 
 namespace
 {
     const std::string StartPositionFen =
         "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
 
+    // "go mate N" without a movetime still has to answer: the loop reads
+    // no "stop" while the solver runs, so cap it at this many ms.
+    constexpr int DefaultMateTimeMs = 10000;
+
     std::vector<std::string> tokenize(const std::string& line)
     {
         std::istringstream stream(line);
@@ -102,7 +113,14 @@ namespace
                 << tokens[index + 5] << ' '
                 << tokens[index + 6];
 
-            board.load_fen(fen.str());
+            FenError error;
+            if (!board.load_fen(fen.str(), &error))
+            {
+                std::cout << "info string invalid fen: " << error.message
+                          << " (column " << error.offset + 1 << ")\n";
+                std::cout.flush();
+                return;
+            }
             index += 7;
         }
         else
@@ -123,6 +141,47 @@ namespace
         }
     }
 
+    // Text after the first token, so file paths may contain spaces.
+    std::string command_argument(const std::string& line)
+    {
+        const std::size_t commandStart = line.find_first_not_of(" \t");
+        const std::size_t commandEnd = line.find_first_of(" \t", commandStart);
+        const std::size_t argumentStart = line.find_first_not_of(" \t", commandEnd);
+        if (argumentStart == std::string::npos)
+        {
+            return {};
+        }
+        const std::size_t argumentEnd = line.find_last_not_of(" \t\r");
+        return line.substr(argumentStart, argumentEnd - argumentStart + 1);
+    }
+
+    // "savehash <file>" / "loadhash <file>": hash table snapshots, so deep
+    // analysis can resume warm in a later session.
+    void handle_hash_file(Engine& engine, const std::string& command, const std::string& path)
+    {
+        if (path.empty())
+        {
+            std::cout << "info string " << command << " needs a file name\n";
+            std::cout.flush();
+            return;
+        }
+
+        std::string error;
+        TranspositionTable& table = engine.transposition_table();
+        const bool saving = (command == "savehash");
+        const bool ok = saving ? table.save(path, error) : table.load(path, error);
+
+        if (ok)
+        {
+            std::cout << "info string hash " << (saving ? "saved to " : "loaded from ") << path << '\n';
+        }
+        else
+        {
+            std::cout << "info string " << command << " failed: " << error << '\n';
+        }
+        std::cout.flush();
+    }
+
     std::string best_move_string(const Move& move)
     {
         if (move.movingPiece == Piece::None &&
@@ -134,10 +193,95 @@ namespace
         return move.to_uci();
     }
 
-    void handle_go(Board& board, const std::vector<std::string>& tokens)
+    // Only ExperienceFile is configurable:
+    //   setoption name ExperienceFile value <path>
+    void handle_setoption(ExperienceStore& experience, const std::string& line)
+    {
+        const std::string lowered = to_lower_copy(line);
+        const std::size_t nameStart = lowered.find(" name ");
+        const std::size_t valueStart = lowered.find(" value ");
+        if (nameStart == std::string::npos || valueStart == std::string::npos || valueStart < nameStart)
+        {
+            return;
+        }
+
+        std::istringstream nameStream(lowered.substr(nameStart + 6, valueStart - nameStart - 6));
+        std::string name;
+        nameStream >> name;
+        if (name != "experiencefile")
+        {
+            return;
+        }
+
+        const std::string path = command_argument(line.substr(valueStart));
+        std::string error;
+        if (path.empty() || path == "<empty>")
+        {
+            return;
+        }
+        if (experience.open(path, error))
+        {
+            std::cout << "info string experience " << path << " holds " << experience.size()
+                      << " positions\n";
+        }
+        else
+        {
+            std::cout << "info string experience file rejected: " << error << '\n';
+        }
+        std::cout.flush();
+    }
+
+    // "go mate N": prove the shortest mate with the df-pn solver, for at
+    // most `movetime` ms or DefaultMateTimeMs without one. Returns false,
+    // after saying so, when there is none within N moves or the time ran
+    // out.
+    bool search_mate(MateSolver& mateSolver, Board& board, int mateMoves, int movetime)
+    {
+        MateLimits limits;
+        limits.maxMoves = mateMoves;
+        limits.timeLimitMs = (movetime > 0) ? movetime : DefaultMateTimeMs;
+
+        const auto start = std::chrono::steady_clock::now();
+        const MateResult result = mateSolver.solve(board, limits);
+        const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count();
+
+        if (!result.found)
+        {
+            std::cout << "info string no mate in " << mateMoves
+                      << (result.aborted ? " found in time" : " exists")
+                      << " nodes " << result.nodes << '\n';
+            return false;
+        }
+
+        const double seconds = elapsedMs > 0 ? static_cast<double>(elapsedMs) / 1000.0 : 0.001;
+        std::cout << "info depth " << result.pv.size()
+                  << " score mate " << result.mateIn
+                  << " nodes " << result.nodes
+                  << " nps " << static_cast<std::int64_t>(result.nodes / seconds)
+                  << " time " << elapsedMs
+                  << " pv";
+        for (const Move& move : result.pv)
+        {
+            std::cout << ' ' << move.to_uci();
+        }
+        std::cout << '\n';
+        std::cout << "bestmove " << best_move_string(result.pv.front()) << '\n';
+        std::cout.flush();
+        return true;
+    }
+
+    void handle_go(Engine& engine,
+                   cluster::Cluster* cluster,
+                   MateSolver& mateSolver,
+                   ExperienceStore& experience,
+                   Board& board,
+                   const std::vector<std::string>& tokens)
     {
         int depth = -1;
         int movetime = 0;
+        int mateMoves = 0;
 
         for (std::size_t i = 1; i < tokens.size(); ++i)
         {
@@ -161,23 +305,58 @@ namespace
                 }
                 ++i;
             }
+            else if (tokenLower == "mate" && i + 1 < tokens.size())
+            {
+                const int parsed = parse_int(tokens[i + 1]);
+                if (parsed > 0)
+                {
+                    mateMoves = parsed;
+                }
+                ++i;
+            }
+        }
+
+        // Without a mate, fall back to a normal search for the move in
+        // whatever is left of the movetime.
+        if (mateMoves > 0)
+        {
+            const auto mateStart = std::chrono::steady_clock::now();
+            if (search_mate(mateSolver, board, mateMoves, movetime))
+            {
+                return;
+            }
+            if (movetime > 0)
+            {
+                const auto spentMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                         std::chrono::steady_clock::now() - mateStart)
+                                         .count();
+                movetime = static_cast<int>(std::max<std::int64_t>(1, movetime - spentMs));
+            }
         }
 
         const int fallbackDepth = (movetime > 0) ? 64 : 6;
         const int maxDepth = (depth > 0) ? depth : fallbackDepth;
 
-        int score = 0;
-        std::int64_t nodes = 0;
-        int searchedDepth = 0;
+        SearchLimits limits;
+        limits.maxDepth = maxDepth;
+        limits.timeLimitMs = movetime;
+        limits.useAbsoluteTime = movetime > 0;
 
-        const Move bestMove = find_best_move(board,
-                                             maxDepth,
-                                             movetime,
-                                             score,
-                                             nodes,
-                                             searchedDepth,
-                                             movetime > 0);
+        const SearchResult result = (cluster != nullptr)
+                                        ? cluster->search(engine, board, limits)
+                                        : engine.find_best_move(board, limits);
+        const Move bestMove = result.bestMove;
+        experience.record(board.zobrist_key(),
+                          ExperienceEntry{pack_move(bestMove),
+                                          static_cast<std::int16_t>(result.score),
+                                          static_cast<std::uint8_t>(result.depth)});
 
+        if (result.lazyEval.calls > 0)
+        {
+            std::cout << "info string lazy eval " << result.lazyEval.lazyExits << " of "
+                      << result.lazyEval.calls << " quiescence evaluations ("
+                      << result.lazyEval.lazyExits * 100 / result.lazyEval.calls << "%)\n";
+        }
         std::cout << "bestmove " << best_move_string(bestMove) << '\n';
         std::cout.flush();
     }
@@ -185,11 +364,28 @@ namespace
 
 namespace uci
 {
-    void run(Board& board, const EngineInfo& info)
+    void run(Board& board, const EngineInfo& info, cluster::Cluster* cluster)
     {
         std::ios::sync_with_stdio(false);
         std::cin.tie(nullptr);
 
+        Engine engine;
+        MateSolver mateSolver;
+        if (cluster != nullptr)
+        {
+            // Report the nodes of every process, not just this one.
+            engine.set_info_callback(
+                [cluster](const SearchInfo& searchInfo)
+                {
+                    std::cout << "info depth " << searchInfo.depth
+                              << " score " << searchInfo.score
+                              << " nodes " << searchInfo.nodes + cluster->helper_nodes()
+                              << " nps " << searchInfo.nps
+                              << " pv " << searchInfo.bestMove.to_uci()
+                              << '\n';
+                });
+        }
+        ExperienceStore experience;
         std::string line;
         while (std::getline(std::cin, line))
         {
@@ -205,6 +401,7 @@ namespace uci
             {
                 std::cout << "id name " << info.name << '\n';
                 std::cout << "id author " << info.author << '\n';
+                std::cout << "option name ExperienceFile type string default <empty>\n";
                 std::cout << "uciok\n";
                 std::cout.flush();
             }
@@ -215,6 +412,16 @@ namespace uci
             }
             else if (command == "ucinewgame")
             {
+                // The previous game is over: persist what it taught us, then
+                // start the new one with that knowledge already in the table.
+                experience.save_async();
+                engine.clear();
+                mateSolver.clear();
+                if (cluster != nullptr)
+                {
+                    cluster->clear();
+                }
+                experience.preload(engine.transposition_table());
                 reset_board(board);
             }
             else if (command == "position")
@@ -223,7 +430,15 @@ namespace uci
             }
             else if (command == "go")
             {
-                handle_go(board, tokens);
+                handle_go(engine, cluster, mateSolver, experience, board, tokens);
+            }
+            else if (command == "setoption")
+            {
+                handle_setoption(experience, line);
+            }
+            else if (command == "savehash" || command == "loadhash")
+            {
+                handle_hash_file(engine, command, command_argument(line));
             }
             else if (command == "stop")
             {
@@ -234,6 +449,8 @@ namespace uci
                 break;
             }
         }
+
+        experience.save_async();
     }
 }
 
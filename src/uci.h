@@ -4,6 +4,11 @@
 
 class Board;
 
+namespace cluster
+{
+    class Cluster;
+}
+
 namespace uci
 {
     struct EngineInfo
@@ -12,6 +17,7 @@ namespace uci
         std::string author;
     };
 
-    void run(Board& board, const EngineInfo& info);
+    // With a cluster, every "go" is searched by its helper processes too.
+    void run(Board& board, const EngineInfo& info, cluster::Cluster* cluster = nullptr);
 }
 
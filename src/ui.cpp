@@ -20,6 +20,7 @@
 #include "move.h"
 #include "notation.h"
 #include "search.h"
+#include "trace.h"
 
 namespace ui
 {
@@ -369,33 +370,43 @@ namespace ui
             return rect;
         }
 
-        bool apply_uci_move(Board& board, const std::string& uci)
+        bool resolve_uci_move(const Position& position, const std::string& uci, Move& outMove)
         {
-            const std::vector<Move> moves = board.generate_legal_moves();
+            const std::vector<Move> moves = position.generate_legal_moves();
             for (const Move& move : moves)
             {
                 if (move.to_uci() == uci)
                 {
-                    board.make_move(move);
+                    outMove = move;
                     return true;
                 }
             }
+            return false;
+        }
+
+        bool apply_uci_move(Board& board, const std::string& uci)
+        {
+            Move move{};
+            if (resolve_uci_move(board.position(), uci, move))
+            {
+                board.make_move(move);
+                return true;
+            }
 
             std::cerr << "Failed to apply UCI move: " << uci << '\n';
             return false;
         }
 
-        bool resolve_uci_move(Board& board, const std::string& uci, Move& outMove)
+        bool apply_uci_move(Position& position, const std::string& uci)
         {
-            const std::vector<Move> moves = board.generate_legal_moves();
-            for (const Move& move : moves)
+            Move move{};
+            if (resolve_uci_move(position, uci, move))
             {
-                if (move.to_uci() == uci)
-                {
-                    outMove = move;
-                    return true;
-                }
+                position.make_move(move);
+                return true;
             }
+
+            std::cerr << "Failed to apply UCI move: " << uci << '\n';
             return false;
         }
 
@@ -540,7 +551,7 @@ namespace ui
             historyState.sanMoves.clear();
             if (!historyState.loaded.moves.empty())
             {
-                Board tmp;
+                Position tmp;
                 tmp.load_fen(
                     historyState.loaded.startFen.empty() ? StartingFen : historyState.loaded.startFen);
 
@@ -809,7 +820,7 @@ namespace ui
             }
         }
 
-        int compute_material_diff(const Board& board)
+        int compute_material_diff(const Position& board)
         {
             int white = 0;
             int black = 0;
@@ -841,7 +852,7 @@ namespace ui
             capturesAtPly.clear();
             materialAtPly.clear();
 
-            Board tmp;
+            Position tmp;
             tmp.load_fen(startFen.empty() ? StartingFen : startFen);
 
             CapturesState captures{};
@@ -1195,7 +1206,7 @@ namespace ui
                 return;
             }
 
-            Board tmp;
+            Position tmp;
             tmp.load_fen(gameState.startFen.empty() ? StartingFen : gameState.startFen);
             gameState.sanMoves.reserve(gameState.movesUci.size());
 
@@ -1371,6 +1382,8 @@ namespace ui
             playViewState,
             static_cast<int>(gameState.movesUci.size()));
 
+        Engine engine;
+
         bool running = true;
         int selectedSquare = -1;
         std::vector<Move> legalMovesForSelected;
@@ -1383,6 +1396,7 @@ namespace ui
 
         while (running)
         {
+            TRACE_ZONE("ui frame");
             const int panelInnerX = BoardPixels + PanelPadding;
             const int panelInnerW = PanelWidth - 2 * PanelPadding;
 
@@ -1418,6 +1432,7 @@ namespace ui
                 moveListHeight};
             const int exportButtonsY = moveListRect.y + moveListRect.h + ButtonSpacing;
 
+            TRACE_NAMED_ZONE(eventsZone, "ui events");
             SDL_Event event;
             while (SDL_PollEvent(&event))
             {
@@ -1492,6 +1507,7 @@ namespace ui
                     else if (key == SDLK_n && mode == UIMode::Play)
                     {
                         reset_game(board, gameState, selectedSquare, legalMovesForSelected);
+                        engine.clear();
                         rebuild_play_caches(gameState);
                         rebuild_play_view(playViewState.viewBoard, gameState, playViewState, 0);
                     }
@@ -1554,6 +1570,7 @@ namespace ui
                         else if (hit_test(newBtn, clickX, clickY))
                         {
                             reset_game(board, gameState, selectedSquare, legalMovesForSelected);
+                            engine.clear();
                             rebuild_play_caches(gameState);
                             playViewState.viewPly = 0;
                             playViewState.moveListScroll = 0;
@@ -1734,17 +1751,12 @@ namespace ui
                                             if (!gameState.gameOver &&
                                                 board.side_to_move() == Color::Black)
                                             {
-                                                int score = 0;
-                                                std::int64_t nodes = 0;
-                                                int depth = 0;
+                                                SearchLimits limits;
+                                                limits.maxDepth = gameState.engineDepth;
+                                                limits.timeLimitMs = gameState.engineTimeMs;
 
                                                 const Move engineMove =
-                                                    find_best_move(board,
-                                                                   gameState.engineDepth,
-                                                                   gameState.engineTimeMs,
-                                                                   score,
-                                                                   nodes,
-                                                                   depth);
+                                                    engine.find_best_move(board, limits).bestMove;
 
                                                 if (!(engineMove.from == 0 &&
                                                       engineMove.to == 0 &&
@@ -2022,6 +2034,7 @@ namespace ui
                     }
                 }
             }
+            TRACE_ZONE_END(eventsZone);
 
             if (mode == UIMode::History && historyState.autoplay && historyState.loadedValid)
             {
@@ -2063,6 +2076,7 @@ namespace ui
                            ? static_cast<const Board&>(board)
                            : static_cast<const Board&>(playViewState.viewBoard));
 
+            TRACE_NAMED_ZONE(renderZone, "ui render");
             SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
             SDL_RenderClear(renderer);
 
@@ -2679,6 +2693,8 @@ namespace ui
                     hasGame);
             }
 
+            TRACE_ZONE_END(renderZone);
+            TRACE_ZONE("ui present");
             SDL_RenderPresent(renderer);
         }
 
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+// Zobrist keys generated at compile time from a fixed seed, so there is no
+// runtime initialization and boards can be built on any thread. Anything
+// persisted by hash key should record ZobristSeed and reject a mismatch.
+inline constexpr std::uint64_t ZobristSeed = 0x9e3779b97f4a7c15ULL;
+
+struct ZobristKeyTable
+{
+    std::uint64_t pieces[13][64]{};
+    std::uint64_t castling[16]{};
+    std::uint64_t enPassant[8]{};
+    std::uint64_t sideToMove{0};
+    // Material signature: [piece][n] is toggled as the n-th (0-based) piece
+    // of that kind enters or leaves the board, so the XOR of a position's
+    // keys depends only on its piece counts.
+    std::uint64_t material[13][64]{};
+};
+
+namespace zobrist_detail
+{
+    // SplitMix64: small, constexpr-friendly and well distributed.
+    constexpr std::uint64_t next_key(std::uint64_t& state)
+    {
+        state += 0x9e3779b97f4a7c15ULL;
+        std::uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    constexpr ZobristKeyTable generate_keys(std::uint64_t seed)
+    {
+        ZobristKeyTable table{};
+        std::uint64_t state = seed;
+
+        // Row 0 (Piece::None) stays zero so empty squares hash without a branch.
+        for (int piece = 1; piece < 13; ++piece)
+        {
+            for (auto& key : table.pieces[piece])
+            {
+                key = next_key(state);
+            }
+        }
+
+        for (auto& key : table.castling)
+        {
+            key = next_key(state);
+        }
+
+        for (auto& key : table.enPassant)
+        {
+            key = next_key(state);
+        }
+
+        table.sideToMove = next_key(state);
+
+        // Drawn after the placement keys so those, and ZobristFingerprint,
+        // stay as they were.
+        for (int piece = 1; piece < 13; ++piece)
+        {
+            for (auto& key : table.material[piece])
+            {
+                key = next_key(state);
+            }
+        }
+        return table;
+    }
+}
+
+inline constexpr ZobristKeyTable ZobristKeys = zobrist_detail::generate_keys(ZobristSeed);
+
+// Mix of a few keys, stored next to ZobristSeed in persisted files to catch
+// generator changes that keep the seed.
+inline constexpr std::uint64_t ZobristFingerprint =
+    ZobristKeys.pieces[1][0] ^ ZobristKeys.castling[15] ^ ZobristKeys.sideToMove;